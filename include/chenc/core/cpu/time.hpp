@@ -0,0 +1,136 @@
+#pragma once
+
+#include "chenc/core/arch.hpp"
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+
+#include <chrono>
+
+#if defined(CHENC_ARCH_X86)
+#	if defined(CHENC_COMPILER_MSVC)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+namespace chenc::cpu {
+	namespace detail {
+		CHENC_FORCE_INLINE u64 steady_ns() noexcept {
+			return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						   std::chrono::steady_clock::now().time_since_epoch())
+						   .count());
+		}
+	} // namespace detail
+
+	/**
+	 * @brief 读取硬件周期计数器
+	 * x86: rdtsc；ARM64: cntvct_el0；其他架构退化为 steady_clock 纳秒。
+	 * 不带序列化指令，只适合估计时长，不适合精确测量单条指令。
+	 */
+	CHENC_FORCE_INLINE u64 read_cycle_counter() noexcept {
+#if defined(CHENC_ARCH_X86)
+#	if defined(CHENC_COMPILER_MSVC)
+		return __rdtsc();
+#	else
+		return __builtin_ia32_rdtsc();
+#	endif
+#elif defined(CHENC_ARCH_ARM_64) && !defined(CHENC_COMPILER_MSVC)
+		u64 v;
+		__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+		return v;
+#else
+		return detail::steady_ns();
+#endif
+	}
+
+	/**
+	 * @brief 基于周期计数器的单调时钟
+	 * 进程启动时（静态初始化阶段）校准一次，不把约 1ms 的忙等留给第一次竞争加锁；
+	 * 更早的静态初始化代码调用 get() 时就地校准：
+	 * - x86 要求不变 TSC（CPUID 0x80000007 EDX[8]），用约 1ms 的忙等对照 steady_clock 求频率
+	 * - ARM64 直接读取 cntfrq_el0
+	 * - 计数器不可用时 now() 返回 steady_clock 纳秒，ticks 与纳秒 1:1
+	 * 用于锁的自旋计时这类只关心"大约过了多久"的场合：一次读数约 10 个周期，而 steady_clock::now() 需要 20–50ns。
+	 */
+	class cycle_clock {
+	public:
+		inline static const cycle_clock &get() noexcept {
+			static const cycle_clock clock;
+			return clock;
+		}
+
+		// 当前读数（单位为 tick）
+		CHENC_FORCE_INLINE u64 now() const noexcept {
+			return use_counter_ ? read_cycle_counter() : detail::steady_ns();
+		}
+
+		inline u64 from_ns(u64 ns) const noexcept { return u64(double(ns) * ticks_per_ns_); }
+		inline u64 to_ns(u64 ticks) const noexcept { return u64(double(ticks) / ticks_per_ns_); }
+
+		inline double ticks_per_ns() const noexcept { return ticks_per_ns_; }
+
+		// 是否在使用硬件计数器
+		inline bool is_cycle_counter() const noexcept { return use_counter_; }
+
+	private:
+		cycle_clock() noexcept {
+#if defined(CHENC_ARCH_X86)
+			if (invariant_tsc()) {
+				calibrate();
+			}
+#elif defined(CHENC_ARCH_ARM_64) && !defined(CHENC_COMPILER_MSVC)
+			u64 freq;
+			__asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+			if (freq != 0) {
+				use_counter_ = true;
+				ticks_per_ns_ = double(freq) / 1e9;
+			}
+#endif
+		}
+
+#if defined(CHENC_ARCH_X86)
+		inline static bool invariant_tsc() noexcept {
+#	if defined(CHENC_COMPILER_MSVC)
+			int regs[4];
+			__cpuid(regs, 0x80000000);
+			if (unsigned(regs[0]) < 0x80000007u) {
+				return false;
+			}
+			__cpuid(regs, 0x80000007);
+			return (regs[3] & (1 << 8)) != 0;
+#	else
+			unsigned a = 0, b = 0, c = 0, d = 0;
+			if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u || !__get_cpuid(0x80000007u, &a, &b, &c, &d)) {
+				return false;
+			}
+			return (d & (1u << 8)) != 0;
+#	endif
+		}
+
+		// 对照 steady_clock 忙等约 1ms
+		inline void calibrate() noexcept {
+			constexpr u64 span_ns = 1'000'000;
+			u64 t0 = detail::steady_ns();
+			u64 c0 = read_cycle_counter();
+			u64 t1;
+			do {
+				t1 = detail::steady_ns();
+			} while (t1 - t0 < span_ns);
+			u64 c1 = read_cycle_counter();
+			if (c1 > c0) {
+				use_counter_ = true;
+				ticks_per_ns_ = double(c1 - c0) / double(t1 - t0);
+			}
+		}
+#endif
+
+		bool use_counter_ = false;
+		double ticks_per_ns_ = 1.0;
+	};
+
+	namespace detail {
+		// 静态初始化阶段触发校准
+		inline const cycle_clock &cycle_clock_startup = cycle_clock::get();
+	} // namespace detail
+} // namespace chenc::cpu
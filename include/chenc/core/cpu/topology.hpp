@@ -0,0 +1,237 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#	include <sched.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+namespace chenc::cpu {
+	// NUMA 节点
+	struct numa_node {
+		u32 id_;				// 节点编号（/sys/devices/system/node/nodeN 中的 N）
+		std::vector<u32> cpus_; // 属于该节点且当前进程允许使用的 CPU
+	};
+
+	/**
+	 * @brief CPU / NUMA 拓扑
+	 * Linux 下读取 /sys/devices/system/node，并按进程 CPU 亲和性过滤；
+	 * 其他平台或读取失败时视为一个包含全部硬件线程的节点。
+	 */
+	class topology {
+	public:
+		// 进程级单例，首次调用时探测
+		inline static const topology &get() {
+			static const topology topo;
+			return topo;
+		}
+
+		inline const std::vector<numa_node> &nodes() const noexcept { return nodes_; }
+		inline u64 node_count() const noexcept { return nodes_.size(); }
+		inline u64 cpu_count() const noexcept { return cpus_.size(); }
+
+		// 按节点分组排列的全部可用 CPU
+		inline const std::vector<u32> &cpus() const noexcept { return cpus_; }
+
+		// CPU 所属节点在 nodes() 中的下标，未知 CPU 返回 0
+		inline u64 node_index_of_cpu(u32 cpu) const noexcept {
+			return cpu < cpu_node_.size() ? cpu_node_[cpu] : 0;
+		}
+
+	private:
+		topology() {
+#if defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			bool has_mask = sched_getaffinity(0, sizeof(set), &set) == 0;
+
+			std::vector<u32> node_ids;
+			{
+				std::ifstream online("/sys/devices/system/node/online");
+				std::string line;
+				if (online && std::getline(online, line)) {
+					node_ids = parse_cpu_list(line); // 与 cpulist 同格式
+				}
+			}
+			for (u32 id : node_ids) {
+				std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+				std::string line;
+				if (!file || !std::getline(file, line)) {
+					continue;
+				}
+				numa_node node{id, {}};
+				for (u32 cpu : parse_cpu_list(line)) {
+					if (!has_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set))) {
+						node.cpus_.push_back(cpu);
+					}
+				}
+				if (!node.cpus_.empty()) {
+					nodes_.push_back(std::move(node));
+				}
+			}
+			if (nodes_.empty() && has_mask) {
+				numa_node node{0, {}};
+				for (u32 cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+					if (CPU_ISSET(cpu, &set)) {
+						node.cpus_.push_back(cpu);
+					}
+				}
+				if (!node.cpus_.empty()) {
+					nodes_.push_back(std::move(node));
+				}
+			}
+#endif
+			if (nodes_.empty()) {
+				numa_node node{0, {}};
+				u32 n = std::max<u32>(1, std::thread::hardware_concurrency());
+				for (u32 cpu = 0; cpu < n; ++cpu) {
+					node.cpus_.push_back(cpu);
+				}
+				nodes_.push_back(std::move(node));
+			}
+
+			for (u64 i = 0; i < nodes_.size(); ++i) {
+				for (u32 cpu : nodes_[i].cpus_) {
+					cpus_.push_back(cpu);
+					if (cpu >= cpu_node_.size()) {
+						cpu_node_.resize(cpu + 1, 0);
+					}
+					cpu_node_[cpu] = u32(i);
+				}
+			}
+		}
+
+		// 解析 "0-3,8,10-11" 形式的 CPU 列表
+		inline static std::vector<u32> parse_cpu_list(const std::string &s) {
+			std::vector<u32> out;
+			u64 i = 0;
+			auto read_num = [&](u32 &v) {
+				if (i >= s.size() || s[i] < '0' || s[i] > '9')
+					return false;
+				v = 0;
+				while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+					v = v * 10 + u32(s[i] - '0');
+					++i;
+				}
+				return true;
+			};
+			while (i < s.size()) {
+				u32 lo = 0, hi = 0;
+				if (!read_num(lo))
+					break;
+				hi = lo;
+				if (i < s.size() && s[i] == '-') {
+					++i;
+					if (!read_num(hi))
+						break;
+				}
+				for (u32 c = lo; c <= hi; ++c) {
+					out.push_back(c);
+				}
+				if (i < s.size() && s[i] == ',')
+					++i;
+				else
+					break;
+			}
+			return out;
+		}
+
+	private:
+		std::vector<numa_node> nodes_;
+		std::vector<u32> cpus_;
+		std::vector<u32> cpu_node_; // cpu -> nodes_ 下标
+	};
+
+	// 当前线程所在的 CPU，无法获取时返回 0
+	inline u32 current_cpu() noexcept {
+#if defined(__linux__)
+		int cpu = sched_getcpu();
+		return cpu < 0 ? 0 : u32(cpu);
+#else
+		return 0;
+#endif
+	}
+
+	// 当前线程所在 NUMA 节点在 topology::nodes() 中的下标
+	inline u64 current_node() noexcept {
+		return topology::get().node_index_of_cpu(current_cpu());
+	}
+
+	/**
+	 * @brief 将当前线程绑定到一组 CPU
+	 * @return 是否成功；非 Linux 平台总是返回 false
+	 */
+	inline bool bind_this_thread(const std::vector<u32> &cpus) noexcept {
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (u32 cpu : cpus) {
+			if (cpu < CPU_SETSIZE) {
+				CPU_SET(cpu, &set);
+			}
+		}
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+		(void)cpus;
+		return false;
+#endif
+	}
+
+	/**
+	 * @brief 在指定 NUMA 节点上分配内存（提示性质）
+	 * Linux 下使用 mmap + mbind(MPOL_PREFERRED)，页面在首次访问时优先落在该节点；
+	 * 其他平台或 mbind 失败时退化为普通的页对齐分配。必须用 numa_free 释放。
+	 * @param node topology::nodes() 中的下标
+	 */
+	inline void *numa_alloc(u64 bytes, u64 node) {
+		if (bytes == 0) {
+			bytes = 1;
+		}
+#if defined(__linux__)
+		void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED) {
+			throw std::bad_alloc();
+		}
+#	if defined(SYS_mbind)
+		const auto &nodes = topology::get().nodes();
+		if (node < nodes.size()) {
+			constexpr int mpol_preferred = 1;
+			unsigned long mask[16] = {};
+			u32 id = nodes[node].id_;
+			if (id < sizeof(mask) * 8) {
+				mask[id / (sizeof(unsigned long) * 8)] |= 1ul << (id % (sizeof(unsigned long) * 8));
+				::syscall(SYS_mbind, p, bytes, mpol_preferred, mask, sizeof(mask) * 8, 0);
+			}
+		}
+#	endif
+		return p;
+#else
+		(void)node;
+		return ::operator new(bytes, std::align_val_t{4096});
+#endif
+	}
+
+	inline void numa_free(void *p, u64 bytes) noexcept {
+		if (p == nullptr) {
+			return;
+		}
+#if defined(__linux__)
+		::munmap(p, bytes == 0 ? 1 : bytes);
+#else
+		(void)bytes;
+		::operator delete(p, std::align_val_t{4096});
+#endif
+	}
+} // namespace chenc::cpu
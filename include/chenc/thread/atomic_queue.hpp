@@ -1,21 +1,30 @@
 #pragma once
 
+#include "chenc/core/cpp.hpp"
 #include "chenc/core/type.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <bit>
 #include <chrono>
 #include <cstddef>
 #include <memory>
+#include <new>
 #include <optional>
 #include <thread>
 #include <vector>
 
 namespace chenc::thread {
-	template <typename T>
+	// 槽位布局
+	enum class queue_layout : u8 {
+		padded, // 序列号独占缓存行：每个槽位至少 128 字节
+		compact // 序列号与值紧凑存放，通过索引重映射让相邻位置落在不同缓存行
+	};
+
+	template <typename T, queue_layout Layout = queue_layout::padded>
 	class atomic_queue {
 	private:
-		struct Node {
+		struct padded_node {
 			// 【值存储核心】使用裸字节数组预留 T 所需空间，避免自动构造
 			alignas(T) std::byte data_[sizeof(T)];
 
@@ -29,6 +38,59 @@ namespace chenc::thread {
 			T *get_ptr() noexcept { return reinterpret_cast<T *>(data_); }
 		};
 
+		struct compact_node {
+			// 序列号含义同 padded_node，仅取消缓存行对齐
+			std::atomic<u64> sequence_{0};
+			alignas(T) std::byte data_[sizeof(T)];
+
+			T *get_ptr() noexcept { return reinterpret_cast<T *>(data_); }
+		};
+
+		using Node = std::conditional_t<Layout == queue_layout::compact, compact_node, padded_node>;
+
+		// 每条缓存行可容纳的槽位数的 log2；槽位大小不能整除缓存行时不做重映射
+		inline static constexpr u64 remap_bits_ = []() {
+			if constexpr (Layout == queue_layout::compact) {
+				if (sizeof(Node) < CHENC_CACHE_LINE && CHENC_CACHE_LINE % sizeof(Node) == 0) {
+					return u64(std::countr_zero(u64(CHENC_CACHE_LINE / sizeof(Node))));
+				}
+			}
+			return u64(0);
+		}();
+		// 重映射要求容量至少为 (每行槽位数)^2
+		inline static constexpr u64 min_capacity_ = u64(1) << (remap_bits_ * 2);
+
+		/**
+		 * @brief 逻辑位置 -> 物理槽位
+		 * 交换索引的低 remap_bits_ 位与次低 remap_bits_ 位，
+		 * 使连续的 pos 分布到不同的缓存行；该变换是自逆的。
+		 */
+		inline static constexpr u64 slot_index(u64 pos, u64 capa) noexcept {
+			u64 idx = pos & (capa - 1);
+			if constexpr (remap_bits_ != 0) {
+				constexpr u64 mask = (u64(1) << remap_bits_) - 1;
+				u64 mix = (idx ^ (idx >> remap_bits_)) & mask;
+				idx ^= mix ^ (mix << remap_bits_);
+			}
+			return idx;
+		}
+
+		// 按缓存行对齐分配槽位数组，保证重映射后的分布与真实缓存行一致
+		inline static Node *alloc_map(u64 capa) {
+			void *raw = ::operator new(sizeof(Node) * capa, std::align_val_t{CHENC_CACHE_LINE});
+			Node *map = static_cast<Node *>(raw);
+			for (u64 i = 0; i < capa; ++i) {
+				new (&map[i]) Node();
+			}
+			return map;
+		}
+		inline static void free_map(Node *map, u64 capa) noexcept {
+			for (u64 i = 0; i < capa; ++i) {
+				map[i].~Node();
+			}
+			::operator delete(static_cast<void *>(map), std::align_val_t{CHENC_CACHE_LINE});
+		}
+
 		// 队列状态：用于在扩容期间“锁住”所有操作
 		enum status : u64 { normal = 0,
 							resizing = 1 };
@@ -45,11 +107,11 @@ namespace chenc::thread {
 
 	public:
 		atomic_queue(u64 initial_capa = 4096) {
-			initial_capa = std::bit_ceil(initial_capa); // 向上取 2 的幂，方便取模优化
-			Node *data = new Node[initial_capa];
+			initial_capa = std::bit_ceil(std::max(initial_capa, min_capacity_)); // 向上取 2 的幂，方便取模优化
+			Node *data = alloc_map(initial_capa);
 			for (u64 i = 0; i < initial_capa; ++i) {
-				// 初始化序列号为槽位索引
-				data[i].sequence_.store(i, std::memory_order_relaxed);
+				// 初始化序列号为槽位对应的逻辑位置
+				data[slot_index(i, initial_capa)].sequence_.store(i, std::memory_order_relaxed);
 			}
 			kmap_.store(data, std::memory_order_relaxed);
 			capacity_.store(initial_capa, std::memory_order_relaxed);
@@ -60,12 +122,12 @@ namespace chenc::thread {
 			if (map) {
 				u64 h = head_pos_.load();
 				u64 t = tail_pos_.load();
-				u64 capa_mask = capacity_.load() - 1;
+				u64 capa = capacity_.load();
 				// 【显式析构】只销毁队列中尚未被消费的存活对象
 				for (u64 i = h; i < t; ++i) {
-					map[i & capa_mask].get_ptr()->~T();
+					map[slot_index(i, capa)].get_ptr()->~T();
 				}
-				delete[] map;
+				free_map(map, capa);
 			}
 		}
 
@@ -90,7 +152,7 @@ namespace chenc::thread {
 				u64 capa = capacity_.load(std::memory_order_relaxed);
 				u64 pos = tail_pos_.load(std::memory_order_relaxed);
 				Node *map = kmap_.load(std::memory_order_relaxed);
-				Node *node = &map[pos & (capa - 1)]; // 位运算代替取模
+				Node *node = &map[slot_index(pos, capa)]; // 位运算代替取模
 				u64 seq = node->sequence_.load(std::memory_order_acquire);
 
 				// 判断逻辑：当前槽位的序列号是否等于我期望写入的位置？
@@ -135,7 +197,7 @@ namespace chenc::thread {
 				u64 capa = capacity_.load(std::memory_order_relaxed);
 				u64 pos = head_pos_.load(std::memory_order_relaxed);
 				Node *map = kmap_.load(std::memory_order_relaxed);
-				Node *node = &map[pos & (capa - 1)];
+				Node *node = &map[slot_index(pos, capa)];
 				u64 seq = node->sequence_.load(std::memory_order_acquire);
 
 				// 判断逻辑：序列号是否等于 pos + 1？（即生产者已完成写入）
@@ -188,20 +250,20 @@ namespace chenc::thread {
 			u64 old_capa = capacity_.load(std::memory_order_relaxed);
 			Node *old_map = kmap_.load(std::memory_order_relaxed);
 			new_capacity = std::bit_ceil(new_capacity);
-			Node *new_map = new Node[new_capacity];
-
-			// 初始化新数组的序列号
-			for (u64 i = 0; i < new_capacity; ++i) {
-				new_map[i].sequence_.store(i, std::memory_order_relaxed);
-			}
+			Node *new_map = alloc_map(new_capacity);
 
 			u64 h = head_pos_.load(std::memory_order_relaxed);
 			u64 t = tail_pos_.load(std::memory_order_relaxed);
 
+			// 初始化新数组的序列号：以当前 head 为起点，每个槽位对应下一轮将访问它的逻辑位置
+			for (u64 i = h; i < h + new_capacity; ++i) {
+				new_map[slot_index(i, new_capacity)].sequence_.store(i, std::memory_order_relaxed);
+			}
+
 			// 数据迁移：将旧数组中的对象搬迁到新数组
 			for (u64 i = h; i < t; ++i) {
-				Node &old_node = old_map[i & (old_capa - 1)];
-				Node &new_node = new_map[i & (new_capacity - 1)];
+				Node &old_node = old_map[slot_index(i, old_capa)];
+				Node &new_node = new_map[slot_index(i, new_capacity)];
 
 				// 在新地址移动构造，并析构旧地址的对象
 				new (new_node.get_ptr()) T(std::move(*old_node.get_ptr()));
@@ -214,7 +276,7 @@ namespace chenc::thread {
 			// 原子更新数组指针和容量
 			kmap_.store(new_map, std::memory_order_release);
 			capacity_.store(new_capacity, std::memory_order_release);
-			delete[] old_map; // 此时已确定没有任何线程在访问 old_map
+			free_map(old_map, old_capa); // 此时已确定没有任何线程在访问 old_map
 
 			// 恢复 normal 状态并通知所有正在 wait 的线程
 			stat_.store(status::normal, std::memory_order_release);
@@ -0,0 +1,698 @@
+#pragma once
+
+#include "chenc/core/cpu/relax.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/atomic_queue.hpp"
+#include "chenc/thread/coroutines.hpp"
+#include "chenc/thread/lock.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+namespace chenc::thread {
+	template <typename T>
+	class channel;
+
+	namespace detail {
+		/**
+		 * @brief select 的认领状态
+		 * 0: 正在各通道登记；1: 已挂起等待；2: 某个通道正在试认领；3 + i: 已被第 i 个通道认领
+		 * 通道先试认领、再从队列取数据，取不到时撤回，所以落选的 select 不会拿走任何数据；
+		 * 试认领只覆盖一次出队，其他观察者遇到时短暂自旋。
+		 * 登记期间被认领时认领方不恢复协程，由 select 自己发现并不挂起
+		 */
+		struct select_state {
+			inline static constexpr u32 registering = 0;
+			inline static constexpr u32 waiting = 1;
+			inline static constexpr u32 claiming = 2;
+			inline static constexpr u32 claimed = 3;
+
+			std::atomic<u32> state_{registering};
+
+			// 试认领：成功时返回原状态（registering / waiting），已被认领时返回 claimed + i
+			inline u32 begin_claim() noexcept {
+				u32 s = state_.load(std::memory_order_acquire);
+				for (;;) {
+					if (s == claiming) {
+						cpu::relax();
+						s = state_.load(std::memory_order_acquire);
+					} else if (s >= claimed) {
+						return s;
+					} else if (state_.compare_exchange_weak(s, claiming, std::memory_order_acquire,
+															std::memory_order_acquire)) {
+						return s;
+					}
+				}
+			}
+
+			inline void finish_claim(u32 index) noexcept { state_.store(claimed + index, std::memory_order_release); }
+			inline void cancel_claim(u32 prev) noexcept { state_.store(prev, std::memory_order_release); }
+
+			// 登记完成后转入等待；登记期间已被认领时返回 false
+			inline bool park() noexcept {
+				u32 expected = registering;
+				while (!state_.compare_exchange_weak(expected, waiting, std::memory_order_acq_rel,
+													 std::memory_order_acquire)) {
+					if (expected >= claimed) {
+						return false;
+					}
+					if (expected == claiming) {
+						cpu::relax();
+					}
+					expected = registering;
+				}
+				return true;
+			}
+		};
+
+		template <typename... Ts>
+		class select_awaiter;
+	} // namespace detail
+
+	/**
+	 * @brief 协程通道（Go 风格）
+	 * - 数据存放在 atomic_queue 中；有界通道另用一个空位计数限制容量
+	 * - 快速路径：有数据 / 有空位且没有等待者时，收发只是一次队列操作加一次计数检查，不加锁、不分配
+	 * - 慢速路径：等待者就是挂起中的 awaiter，串在通道内的侵入式双向链表上（由短自旋锁保护）；
+	 *   发送方把值直接交给最早的接收等待者，再经调度器恢复它
+	 * - close() 之后 send 返回 false；recv 先取完剩余数据，然后返回 std::nullopt
+	 */
+	template <typename T>
+	class channel {
+	public:
+		inline static constexpr u64 unbounded = u64(-1);
+
+	private:
+		template <typename... Ts>
+		friend class detail::select_awaiter;
+
+		// 接收等待者
+		struct recv_node {
+			recv_node *prev_ = nullptr;
+			recv_node *next_ = nullptr;
+			bool linked_ = false;
+			std::optional<T> *slot_ = nullptr;			  // 交付目标
+			detail::select_state *select_ = nullptr;	  // select 登记时非空
+			u32 index_ = 0;								  // 在 select 中的序号
+			std::coroutine_handle<> handle_{};
+			thread_pool *pool_ = nullptr;
+		};
+
+		// 发送等待者（仅有界通道）
+		struct send_node {
+			send_node *prev_ = nullptr;
+			send_node *next_ = nullptr;
+			T *value_ = nullptr;
+			bool ok_ = false;
+			std::coroutine_handle<> handle_{};
+			thread_pool *pool_ = nullptr;
+		};
+
+		// 侵入式双向链表
+		template <typename Node>
+		struct node_list {
+			Node *head_ = nullptr;
+			Node *tail_ = nullptr;
+
+			inline bool empty() const noexcept { return head_ == nullptr; }
+
+			inline void push_back(Node *n) noexcept {
+				n->next_ = nullptr;
+				n->prev_ = tail_;
+				if (tail_ != nullptr) {
+					tail_->next_ = n;
+				} else {
+					head_ = n;
+				}
+				tail_ = n;
+			}
+
+			inline void erase(Node *n) noexcept {
+				(n->prev_ != nullptr ? n->prev_->next_ : head_) = n->next_;
+				(n->next_ != nullptr ? n->next_->prev_ : tail_) = n->prev_;
+				n->prev_ = nullptr;
+				n->next_ = nullptr;
+			}
+
+			inline Node *front() const noexcept { return head_; }
+
+			inline Node *pop_front() noexcept {
+				Node *n = head_;
+				if (n != nullptr) {
+					erase(n);
+				}
+				return n;
+			}
+		};
+
+	public:
+		class recv_awaiter {
+		public:
+			inline bool await_ready() {
+				result_ = ch_.try_recv();
+				return result_.has_value() || ch_.drained();
+			}
+
+			inline bool await_suspend(std::coroutine_handle<> h) {
+				node_.handle_ = h;
+				node_.pool_ = thread_pool::current();
+				node_.slot_ = &result_;
+				return ch_.wait_recv(node_);
+			}
+
+			inline std::optional<T> await_resume() noexcept { return std::move(result_); }
+
+		private:
+			friend class channel;
+			explicit recv_awaiter(channel &ch) noexcept
+				: ch_(ch) {}
+
+			channel &ch_;
+			recv_node node_{};
+			std::optional<T> result_{};
+		};
+
+		class send_awaiter {
+		public:
+			inline bool await_ready() {
+				if (ch_.closed()) {
+					return true;
+				}
+				ok_ = ch_.try_send(value_);
+				return ok_;
+			}
+
+			inline bool await_suspend(std::coroutine_handle<> h) {
+				node_.handle_ = h;
+				node_.pool_ = thread_pool::current();
+				node_.value_ = &value_;
+				return ch_.wait_send(node_); // 挂起后不能再访问成员
+			}
+
+			// 通道已关闭时返回 false
+			inline bool await_resume() const noexcept { return ok_ || node_.ok_; }
+
+		private:
+			friend class channel;
+			send_awaiter(channel &ch, T &&value)
+				: ch_(ch), value_(std::move(value)) {}
+
+			channel &ch_;
+			T value_;
+			send_node node_{};
+			bool ok_ = false;
+		};
+
+		class batch_awaiter {
+		public:
+			inline bool await_ready() {
+				count_ = ch_.try_recv_batch(out_);
+				return count_ != 0 || out_.empty() || ch_.drained();
+			}
+
+			inline bool await_suspend(std::coroutine_handle<> h) {
+				node_.handle_ = h;
+				node_.pool_ = thread_pool::current();
+				node_.slot_ = &first_;
+				return ch_.wait_recv(node_);
+			}
+
+			// 返回写入 out 的元素数；0 表示通道已关闭且取空
+			inline u64 await_resume() {
+				if (count_ != 0 || !first_.has_value()) {
+					return count_;
+				}
+				out_[0] = std::move(*first_);
+				return 1 + ch_.try_recv_batch(out_.subspan(1));
+			}
+
+		private:
+			friend class channel;
+			batch_awaiter(channel &ch, std::span<T> out) noexcept
+				: ch_(ch), out_(out) {}
+
+			channel &ch_;
+			std::span<T> out_;
+			recv_node node_{};
+			std::optional<T> first_{};
+			u64 count_ = 0;
+		};
+
+	public:
+		/**
+		 * @param capacity 容量，unbounded 表示无界
+		 * @param initial_capacity 底层队列的初始槽位数（无界通道按需扩容）
+		 */
+		explicit channel(u64 capacity = unbounded, u64 initial_capacity = 1024)
+			: queue_(capacity == unbounded ? initial_capacity : std::max<u64>(capacity, 1)),
+			  capacity_(capacity == unbounded ? unbounded : std::max<u64>(capacity, 1)),
+			  space_(capacity == unbounded ? 0 : i64(std::max<u64>(capacity, 1))) {}
+
+		channel(const channel &) = delete;
+		channel &operator=(const channel &) = delete;
+
+		// ============================
+		// 发送
+		// ============================
+
+		// co_await ch.send(v)：有界通道满时挂起；返回 false 表示通道已关闭
+		[[nodiscard]] inline send_awaiter send(T value) { return send_awaiter(*this, std::move(value)); }
+
+		// 不挂起的发送；成功时 value 被移走
+		inline bool try_send(T &value) {
+			if (closed()) {
+				return false;
+			}
+			if (bounded() && !try_acquire_space()) {
+				return false;
+			}
+			queue_.push(std::move(value));
+			on_pushed();
+			return true;
+		}
+
+		// ============================
+		// 接收
+		// ============================
+
+		// co_await ch.recv()：没有数据时挂起；通道关闭且取空后返回 std::nullopt
+		[[nodiscard]] inline recv_awaiter recv() noexcept { return recv_awaiter(*this); }
+
+		// co_await ch.recv_batch(out)：至少取到一个元素（或通道关闭）后返回，最多取 out.size() 个
+		[[nodiscard]] inline batch_awaiter recv_batch(std::span<T> out) noexcept { return batch_awaiter(*this, out); }
+
+		// 不挂起的接收
+		inline std::optional<T> try_recv() {
+			std::optional<T> v = queue_.pop();
+			if (v.has_value()) {
+				on_consumed(1);
+			}
+			return v;
+		}
+
+		// 不挂起的批量接收，返回取到的元素数
+		inline u64 try_recv_batch(std::span<T> out) {
+			u64 n = 0;
+			while (n < out.size()) {
+				std::optional<T> v = queue_.pop();
+				if (!v.has_value()) {
+					break;
+				}
+				out[n++] = std::move(*v);
+			}
+			if (n != 0) {
+				on_consumed(n);
+			}
+			return n;
+		}
+
+		// ============================
+		// 状态
+		// ============================
+
+		// 关闭通道：唤醒所有等待者；剩余数据仍可被接收
+		void close() {
+			recv_node *recv_ready = nullptr;
+			send_node *send_ready = nullptr;
+			u64 delivered = 0;
+			{
+				std::scoped_lock guard(mtx_);
+				if (closed_.exchange(true, std::memory_order_acq_rel)) {
+					return;
+				}
+				delivered = handoff_locked(recv_ready);
+				while (recv_node *w = recv_waiters_.pop_front()) {
+					unlink_recv(w);
+					u32 prev = claim(w);
+					if (prev >= detail::select_state::claimed) {
+						continue;
+					}
+					// 槽位保持为空，表示通道关闭
+					if (complete(w, prev)) {
+						w->next_ = recv_ready;
+						recv_ready = w;
+					}
+				}
+				while (send_node *w = send_waiters_.pop_front()) {
+					send_waiting_.fetch_sub(1, std::memory_order_relaxed);
+					w->ok_ = false;
+					w->next_ = send_ready;
+					send_ready = w;
+				}
+			}
+			resume_all(recv_ready);
+			resume_all(send_ready);
+			on_consumed(delivered);
+		}
+
+		inline bool closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+		inline bool bounded() const noexcept { return capacity_ != unbounded; }
+		inline u64 capacity() const noexcept { return capacity_; }
+
+		// 当前缓冲的元素数（非严格一致）
+		inline u64 size() const noexcept { return queue_.size(); }
+
+	private:
+		// 已关闭且没有剩余数据
+		inline bool drained() const noexcept { return closed() && queue_.size() == 0; }
+
+		// ============================
+		// 容量
+		// ============================
+
+		inline bool try_acquire_space() noexcept {
+			i64 s = space_.load(std::memory_order_relaxed);
+			while (s > 0) {
+				if (space_.compare_exchange_weak(s, s - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// n 个元素被取走：归还空位，并让等待的发送者入队
+		void on_consumed(u64 n) {
+			while (n != 0 && bounded()) {
+				space_.fetch_add(i64(n), std::memory_order_release);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (send_waiting_.load(std::memory_order_relaxed) == 0) [[likely]] {
+					return;
+				}
+				send_node *send_ready = nullptr;
+				recv_node *recv_ready = nullptr;
+				{
+					std::scoped_lock guard(mtx_);
+					while (!send_waiters_.empty() && try_acquire_space()) {
+						send_node *w = send_waiters_.pop_front();
+						send_waiting_.fetch_sub(1, std::memory_order_relaxed);
+						queue_.push(std::move(*w->value_));
+						w->ok_ = true;
+						w->next_ = send_ready;
+						send_ready = w;
+					}
+					n = handoff_locked(recv_ready);
+				}
+				resume_all(send_ready);
+				resume_all(recv_ready);
+			}
+		}
+
+		// 入队之后：有接收等待者时把数据交给它们
+		inline void on_pushed() {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (recv_waiting_.load(std::memory_order_relaxed) == 0) [[likely]] {
+				return;
+			}
+			recv_node *ready = nullptr;
+			u64 delivered;
+			{
+				std::scoped_lock guard(mtx_);
+				delivered = handoff_locked(ready);
+			}
+			resume_all(ready);
+			on_consumed(delivered);
+		}
+
+		// ============================
+		// 等待者（持有 mtx_）
+		// ============================
+
+		/**
+		 * 把队列中的数据按 FIFO 交给接收等待者，返回交付数；需要恢复的等待者串入 ready
+		 * 先认领等待者再出队：已被其他通道认领的 select 直接跳过，数据始终留在队列中的原位置
+		 */
+		u64 handoff_locked(recv_node *&ready) {
+			u64 delivered = 0;
+			while (recv_node *w = recv_waiters_.front()) {
+				u32 prev = claim(w);
+				if (prev >= detail::select_state::claimed) {
+					recv_waiters_.pop_front();
+					unlink_recv(w);
+					continue;
+				}
+				std::optional<T> v = queue_.pop();
+				if (!v.has_value()) {
+					if (w->select_ != nullptr) {
+						w->select_->cancel_claim(prev);
+					}
+					break;
+				}
+				recv_waiters_.pop_front();
+				unlink_recv(w);
+				*w->slot_ = std::move(v);
+				if (complete(w, prev)) {
+					w->next_ = ready;
+					ready = w;
+				}
+				delivered++;
+			}
+			return delivered;
+		}
+
+		/**
+		 * @brief 试认领等待者
+		 * 普通等待者视为 waiting；select 等待者返回 begin_claim() 的结果，
+		 * 不小于 select_state::claimed 时已被其他通道认领，不能交付
+		 */
+		inline static u32 claim(recv_node *w) noexcept {
+			if (w->select_ == nullptr) {
+				return detail::select_state::waiting;
+			}
+			return w->select_->begin_claim();
+		}
+
+		// 槽位写好后完成认领，返回是否需要恢复等待者
+		inline static bool complete(recv_node *w, u32 prev) noexcept {
+			if (w->select_ != nullptr) {
+				w->select_->finish_claim(w->index_);
+			}
+			return prev == detail::select_state::waiting;
+		}
+
+		inline void unlink_recv(recv_node *w) noexcept {
+			w->linked_ = false;
+			recv_waiting_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		template <typename Node>
+		inline static void resume_all(Node *w) noexcept {
+			while (w != nullptr) {
+				Node *next = w->next_; // 恢复后 awaiter 可能随协程帧一起失效
+				detail::resume_waiter(w->pool_, w->handle_);
+				w = next;
+			}
+		}
+
+		// 接收慢速路径：登记后复查，返回是否挂起；不挂起时结果已写入 node.slot_
+		bool wait_recv(recv_node &node) {
+			std::optional<T> v;
+			{
+				std::scoped_lock guard(mtx_);
+				recv_waiting_.fetch_add(1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				v = queue_.pop();
+				if (!v.has_value() && !closed()) {
+					node.linked_ = true;
+					recv_waiters_.push_back(&node);
+					return true;
+				}
+				recv_waiting_.fetch_sub(1, std::memory_order_relaxed);
+			}
+			if (v.has_value()) {
+				*node.slot_ = std::move(v);
+				on_consumed(1);
+			}
+			return false;
+		}
+
+		// 发送慢速路径：登记后复查，返回是否挂起；不挂起时 node.ok_ 为结果
+		bool wait_send(send_node &node) {
+			{
+				std::scoped_lock guard(mtx_);
+				send_waiting_.fetch_add(1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (closed()) {
+					send_waiting_.fetch_sub(1, std::memory_order_relaxed);
+					node.ok_ = false;
+					return false;
+				}
+				if (!try_acquire_space()) {
+					send_waiters_.push_back(&node);
+					return true;
+				}
+				send_waiting_.fetch_sub(1, std::memory_order_relaxed);
+			}
+			queue_.push(std::move(*node.value_));
+			node.ok_ = true;
+			on_pushed();
+			return false;
+		}
+
+		/**
+		 * @brief select 登记
+		 * 返回 0 已登记，1 取到数据（已写入槽位并认领），2 通道已关闭（已认领），3 已被其他通道认领
+		 * 先认领自己再出队，取不到数据时撤回，落选时不会拿走数据
+		 */
+		int register_select(recv_node &node) {
+			std::scoped_lock guard(mtx_);
+			recv_waiting_.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			u32 prev = node.select_->begin_claim();
+			if (prev >= detail::select_state::claimed) {
+				recv_waiting_.fetch_sub(1, std::memory_order_relaxed);
+				return 3;
+			}
+			std::optional<T> v = queue_.pop();
+			if (v.has_value()) {
+				recv_waiting_.fetch_sub(1, std::memory_order_relaxed);
+				*node.slot_ = std::move(v);
+				node.select_->finish_claim(node.index_);
+				return 1;
+			}
+			if (closed()) {
+				recv_waiting_.fetch_sub(1, std::memory_order_relaxed);
+				node.select_->finish_claim(node.index_);
+				return 2;
+			}
+			node.select_->cancel_claim(prev);
+			node.linked_ = true;
+			recv_waiters_.push_back(&node);
+			return 0;
+		}
+
+		// select 结束：从等待链表中移除（已被移除时什么都不做）
+		inline void unregister_select(recv_node &node) {
+			std::scoped_lock guard(mtx_);
+			if (node.linked_) {
+				recv_waiters_.erase(&node);
+				unlink_recv(&node);
+			}
+		}
+
+	private:
+		atomic_queue<T> queue_;
+		const u64 capacity_;
+		CHENC_CACHE_ALIGN std::atomic<i64> space_; // 有界通道的空位数
+		CHENC_CACHE_ALIGN std::atomic<u64> recv_waiting_{0};
+		std::atomic<u64> send_waiting_{0};
+		std::atomic<bool> closed_{false};
+		lock::mutex<> mtx_;
+		node_list<recv_node> recv_waiters_;
+		node_list<send_node> send_waiters_;
+	};
+
+	namespace detail {
+		/**
+		 * @brief select 的 awaiter
+		 * 先按顺序尝试各通道；都没有数据时在每个通道登记一个等待节点，第一个交付数据（或关闭）的通道认领它。
+		 * 恢复后从其余通道注销。
+		 */
+		template <typename... Ts>
+		class select_awaiter {
+		public:
+			using result_type = std::variant<std::optional<Ts>...>;
+
+			explicit select_awaiter(channel<Ts> &...chs) noexcept
+				: chs_(chs...) {}
+
+			inline bool await_ready() { return poll<0>(); }
+
+			inline bool await_suspend(std::coroutine_handle<> h) {
+				thread_pool *pool = thread_pool::current();
+				if (register_all<0>(h, pool)) {
+					return false;
+				}
+				return state_.park();
+			}
+
+			inline result_type await_resume() {
+				unregister_all(std::index_sequence_for<Ts...>{});
+				return take<0>(state_.state_.load(std::memory_order_acquire) - select_state::claimed);
+			}
+
+		private:
+			// 不挂起地依次尝试各通道；第一个有数据或已取空关闭的通道胜出
+			template <u64 I>
+			inline bool poll() {
+				if constexpr (I == sizeof...(Ts)) {
+					return false;
+				} else {
+					auto &ch = std::get<I>(chs_);
+					auto &slot = std::get<I>(slots_);
+					slot = ch.try_recv();
+					if (slot.has_value() || ch.drained()) {
+						state_.state_.store(select_state::claimed + u32(I), std::memory_order_relaxed);
+						return true;
+					}
+					return poll<I + 1>();
+				}
+			}
+
+			// 在各通道登记；登记过程中已有结果时返回 true（不挂起）
+			template <u64 I>
+			inline bool register_all(std::coroutine_handle<> h, thread_pool *pool) {
+				if constexpr (I == sizeof...(Ts)) {
+					return false;
+				} else {
+					auto &ch = std::get<I>(chs_);
+					auto &node = std::get<I>(nodes_);
+					auto &slot = std::get<I>(slots_);
+					node.slot_ = &slot;
+					node.select_ = &state_;
+					node.index_ = u32(I);
+					node.handle_ = h;
+					node.pool_ = pool;
+					int r = ch.register_select(node);
+					if (r == 0) {
+						return register_all<I + 1>(h, pool);
+					}
+					// 取到数据、发现关闭（均已认领自己），或已被之前登记的通道认领
+					if (r == 1) {
+						ch.on_consumed(1);
+					}
+					return true;
+				}
+			}
+
+			template <u64... I>
+			inline void unregister_all(std::index_sequence<I...>) {
+				(std::get<I>(chs_).unregister_select(std::get<I>(nodes_)), ...);
+			}
+
+			template <u64 I>
+			inline result_type take(u32 index) {
+				if constexpr (I + 1 == sizeof...(Ts)) {
+					return result_type(std::in_place_index<I>, std::move(std::get<I>(slots_)));
+				} else {
+					if (index == I) {
+						return result_type(std::in_place_index<I>, std::move(std::get<I>(slots_)));
+					}
+					return take<I + 1>(index);
+				}
+			}
+
+			std::tuple<channel<Ts> &...> chs_;
+			std::tuple<typename channel<Ts>::recv_node...> nodes_{};
+			std::tuple<std::optional<Ts>...> slots_{};
+			select_state state_{};
+		};
+	} // namespace detail
+
+	/**
+	 * @brief 同时等待多个通道
+	 * auto r = co_await select(a, b); r.index() 为就绪的通道序号，
+	 * std::get<i>(r) 为取到的值，std::nullopt 表示该通道已关闭且取空。
+	 */
+	template <typename... Ts>
+		requires(sizeof...(Ts) > 0)
+	[[nodiscard]] inline detail::select_awaiter<Ts...> select(channel<Ts> &...chs) noexcept {
+		return detail::select_awaiter<Ts...>(chs...);
+	}
+} // namespace chenc::thread
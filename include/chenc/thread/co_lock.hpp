@@ -2,21 +2,378 @@
 
 #include "chenc/core/cpu/relax.hpp"
 #include "chenc/core/type.hpp"
+#include "chenc/thread/coroutines.hpp"
+#include "chenc/thread/lock.hpp"
 
 #include <atomic>
-#include <bit>
-#include <chrono>
-#include <semaphore>
-#include <thread>
-
-namespace chenc {
-	// 独占锁
-	class lock {
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace chenc::thread {
+	/**
+	 * @brief 协程互斥锁的作用域守卫，析构时解锁
+	 * M 为 co_mutex 时调用 unlock()，Shared 为 true 时调用 unlock_shared()
+	 */
+	template <typename M, bool Shared = false>
+	class co_lock_guard {
+	public:
+		explicit co_lock_guard(M &m, std::adopt_lock_t) noexcept
+			: m_(&m) {}
+		co_lock_guard(co_lock_guard &&other) noexcept
+			: m_(std::exchange(other.m_, nullptr)) {}
+		co_lock_guard(const co_lock_guard &) = delete;
+		co_lock_guard &operator=(const co_lock_guard &) = delete;
+		co_lock_guard &operator=(co_lock_guard &&) = delete;
+
+		~co_lock_guard() { unlock(); }
+
+		// 提前解锁
+		inline void unlock() noexcept {
+			if (M *m = std::exchange(m_, nullptr)) {
+				if constexpr (Shared) {
+					m->unlock_shared();
+				} else {
+					m->unlock();
+				}
+			}
+		}
+
+	private:
+		M *m_;
 	};
-	// 递归锁
-	class re_lock {
+
+	/**
+	 * @brief 协程互斥锁
+	 * - 状态字：not_locked / 已锁无等待者（0）/ 已锁且指向等待者栈顶
+	 * - 等待者就是挂起中的 awaiter 本身，用 CAS 压入状态字（无锁、不分配）
+	 * - unlock 由持锁者把栈整体取走并反转为 FIFO，锁直接移交给队首等待者并经调度器恢复它，
+	 *   被恢复的协程不需要再竞争
+	 */
+	class co_mutex {
+	private:
+		struct lock_awaiter;
+
+		inline static constexpr std::uintptr_t not_locked = 1;
+		inline static constexpr std::uintptr_t locked_no_waiters = 0;
+
+		struct lock_awaiter {
+			co_mutex &m_;
+			lock_awaiter *next_ = nullptr;
+			std::coroutine_handle<> handle_{};
+			thread_pool *pool_ = nullptr;
+
+			inline bool await_ready() const noexcept { return m_.try_lock(); }
+
+			inline bool await_suspend(std::coroutine_handle<> h) noexcept {
+				handle_ = h;
+				pool_ = thread_pool::current();
+				std::uintptr_t old = m_.state_.load(std::memory_order_acquire);
+				while (true) {
+					if (old == not_locked) {
+						if (m_.state_.compare_exchange_weak(old, locked_no_waiters,
+															std::memory_order_acquire,
+															std::memory_order_relaxed)) {
+							return false; // 锁在此期间被释放，直接持有
+						}
+					} else {
+						next_ = reinterpret_cast<lock_awaiter *>(old);
+						if (m_.state_.compare_exchange_weak(old, reinterpret_cast<std::uintptr_t>(this),
+															std::memory_order_release,
+															std::memory_order_relaxed)) {
+							return true;
+						}
+					}
+				}
+			}
+
+			inline void await_resume() const noexcept {}
+		};
+
+		struct scoped_lock_awaiter : lock_awaiter {
+			inline co_lock_guard<co_mutex> await_resume() const noexcept {
+				return co_lock_guard<co_mutex>(m_, std::adopt_lock);
+			}
+		};
+
+	public:
+		co_mutex() noexcept = default;
+		co_mutex(const co_mutex &) = delete;
+		co_mutex &operator=(const co_mutex &) = delete;
+
+		[[nodiscard]] inline bool try_lock() noexcept {
+			std::uintptr_t expected = not_locked;
+			return state_.compare_exchange_strong(expected, locked_no_waiters,
+												  std::memory_order_acquire,
+												  std::memory_order_relaxed);
+		}
+
+		// co_await m.lock()
+		[[nodiscard]] inline lock_awaiter lock() noexcept { return lock_awaiter{*this}; }
+
+		// auto guard = co_await m.scoped_lock()
+		[[nodiscard]] inline scoped_lock_awaiter scoped_lock() noexcept { return scoped_lock_awaiter{{*this}}; }
+
+		// 有等待者时把锁移交给最早的等待者
+		inline void unlock() noexcept {
+			lock_awaiter *w = waiters_;
+			if (w == nullptr) {
+				std::uintptr_t old = locked_no_waiters;
+				if (state_.compare_exchange_strong(old, not_locked,
+												   std::memory_order_release,
+												   std::memory_order_relaxed)) {
+					return;
+				}
+				// 取走新压入的等待者栈，反转为 FIFO
+				old = state_.exchange(locked_no_waiters, std::memory_order_acquire);
+				lock_awaiter *s = reinterpret_cast<lock_awaiter *>(old);
+				do {
+					lock_awaiter *next = s->next_;
+					s->next_ = w;
+					w = s;
+					s = next;
+				} while (s != nullptr);
+			}
+			waiters_ = w->next_;
+			detail::resume_waiter(w->pool_, w->handle_);
+		}
+
+	private:
+		std::atomic<std::uintptr_t> state_{not_locked};
+		lock_awaiter *waiters_ = nullptr; // 已按 FIFO 排好的等待者，仅持锁者访问
 	};
-	// 读写锁
-	class rw_lock {
+
+	/**
+	 * @brief 协程计数信号量
+	 * - 计数为正时 acquire 只是一次 fetch_sub
+	 * - 计数不足的 acquire 把 awaiter 压入无锁等待栈（不分配）
+	 * - release 在计数为负时唤醒一个等待者：唤醒方之间用一个短自旋锁串行化栈的取走与 FIFO 排序
+	 */
+	class co_semaphore {
+	private:
+		struct acquire_awaiter {
+			co_semaphore &s_;
+			acquire_awaiter *next_ = nullptr;
+			std::coroutine_handle<> handle_{};
+			thread_pool *pool_ = nullptr;
+
+			inline bool await_ready() const noexcept { return false; }
+
+			inline bool await_suspend(std::coroutine_handle<> h) noexcept {
+				if (s_.count_.fetch_sub(1, std::memory_order_acquire) > 0) {
+					return false;
+				}
+				handle_ = h;
+				pool_ = thread_pool::current();
+				acquire_awaiter *head = s_.stack_.load(std::memory_order_relaxed);
+				do {
+					next_ = head;
+				} while (!s_.stack_.compare_exchange_weak(head, this,
+														  std::memory_order_release,
+														  std::memory_order_relaxed));
+				return true;
+			}
+
+			inline void await_resume() const noexcept {}
+		};
+
+	public:
+		explicit co_semaphore(i64 initial = 0) noexcept
+			: count_(initial) {}
+		co_semaphore(const co_semaphore &) = delete;
+		co_semaphore &operator=(const co_semaphore &) = delete;
+
+		[[nodiscard]] inline bool try_acquire() noexcept {
+			i64 c = count_.load(std::memory_order_relaxed);
+			while (c > 0) {
+				if (count_.compare_exchange_weak(c, c - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// co_await s.acquire()
+		[[nodiscard]] inline acquire_awaiter acquire() noexcept { return acquire_awaiter{*this}; }
+
+		inline void release(i64 n = 1) noexcept {
+			for (; n > 0; --n) {
+				if (count_.fetch_add(1, std::memory_order_release) < 0) {
+					wake_one();
+				}
+			}
+		}
+
+		// 当前可用计数，负数表示等待者个数（非严格一致）
+		inline i64 available() const noexcept { return count_.load(std::memory_order_relaxed); }
+
+	private:
+		// 计数为负说明有一个 acquire 已承诺等待，它可能还没压栈：自旋到它出现为止
+		inline void wake_one() noexcept {
+			acquire_awaiter *w;
+			{
+				std::scoped_lock guard(wake_lock_);
+				if (fifo_ == nullptr) {
+					acquire_awaiter *s;
+					while ((s = stack_.exchange(nullptr, std::memory_order_acquire)) == nullptr) {
+						cpu::relax();
+					}
+					do {
+						acquire_awaiter *next = s->next_;
+						s->next_ = fifo_;
+						fifo_ = s;
+						s = next;
+					} while (s != nullptr);
+				}
+				w = fifo_;
+				fifo_ = w->next_;
+			}
+			detail::resume_waiter(w->pool_, w->handle_);
+		}
+
+		std::atomic<i64> count_;
+		std::atomic<acquire_awaiter *> stack_{nullptr};
+		lock::mutex<> wake_lock_;
+		acquire_awaiter *fifo_ = nullptr; // wake_lock_ 保护
+	};
+
+	/**
+	 * @brief 协程读写锁（公平，FIFO）
+	 * - 等待者就是挂起中的 awaiter，按到达顺序串成侵入式队列，不分配
+	 * - 状态与队列由一个短自旋锁保护；锁内只做计数与链表操作，恢复协程在锁外经调度器进行
+	 * - 有等待者时新来的读者也排队，写者不会被饿死；释放时队首若为读者，则连续的读者一起被放行
+	 */
+	class co_shared_mutex {
+	private:
+		struct waiter {
+			co_shared_mutex &m_;
+			bool shared_;
+			waiter *next_ = nullptr;
+			std::coroutine_handle<> handle_{};
+			thread_pool *pool_ = nullptr;
+
+			inline bool await_ready() const noexcept {
+				return shared_ ? m_.try_lock_shared() : m_.try_lock();
+			}
+
+			inline bool await_suspend(std::coroutine_handle<> h) noexcept {
+				handle_ = h;
+				pool_ = thread_pool::current();
+				std::scoped_lock guard(m_.mtx_);
+				if (m_.head_ == nullptr && (shared_ ? !m_.writer_ : (!m_.writer_ && m_.readers_ == 0))) {
+					if (shared_) {
+						m_.readers_++;
+					} else {
+						m_.writer_ = true;
+					}
+					return false;
+				}
+				if (m_.tail_ == nullptr) {
+					m_.head_ = this;
+				} else {
+					m_.tail_->next_ = this;
+				}
+				m_.tail_ = this;
+				return true;
+			}
+
+			inline void await_resume() const noexcept {}
+		};
+
+		template <bool Shared>
+		struct scoped_waiter : waiter {
+			inline co_lock_guard<co_shared_mutex, Shared> await_resume() const noexcept {
+				return co_lock_guard<co_shared_mutex, Shared>(this->m_, std::adopt_lock);
+			}
+		};
+
+	public:
+		co_shared_mutex() noexcept = default;
+		co_shared_mutex(const co_shared_mutex &) = delete;
+		co_shared_mutex &operator=(const co_shared_mutex &) = delete;
+
+		[[nodiscard]] inline bool try_lock() noexcept {
+			std::scoped_lock guard(mtx_);
+			if (writer_ || readers_ != 0 || head_ != nullptr) {
+				return false;
+			}
+			writer_ = true;
+			return true;
+		}
+
+		[[nodiscard]] inline bool try_lock_shared() noexcept {
+			std::scoped_lock guard(mtx_);
+			if (writer_ || head_ != nullptr) {
+				return false;
+			}
+			readers_++;
+			return true;
+		}
+
+		[[nodiscard]] inline waiter lock() noexcept { return waiter{*this, false}; }
+		[[nodiscard]] inline waiter lock_shared() noexcept { return waiter{*this, true}; }
+		[[nodiscard]] inline scoped_waiter<false> scoped_lock() noexcept { return {{*this, false}}; }
+		[[nodiscard]] inline scoped_waiter<true> scoped_lock_shared() noexcept { return {{*this, true}}; }
+
+		inline void unlock() noexcept {
+			waiter *ready;
+			{
+				std::scoped_lock guard(mtx_);
+				writer_ = false;
+				ready = grant();
+			}
+			resume_all(ready);
+		}
+
+		inline void unlock_shared() noexcept {
+			waiter *ready = nullptr;
+			{
+				std::scoped_lock guard(mtx_);
+				if (--readers_ == 0) {
+					ready = grant();
+				}
+			}
+			resume_all(ready);
+		}
+
+	private:
+		// 锁空闲时（持有 mtx_）把锁授予队首：一个写者，或一串连续的读者；返回被授予者链表
+		inline waiter *grant() noexcept {
+			waiter *first = head_;
+			if (first == nullptr) {
+				return nullptr;
+			}
+			waiter *last = first;
+			if (!first->shared_) {
+				writer_ = true;
+			} else {
+				readers_++;
+				while (last->next_ != nullptr && last->next_->shared_) {
+					last = last->next_;
+					readers_++;
+				}
+			}
+			head_ = last->next_;
+			if (head_ == nullptr) {
+				tail_ = nullptr;
+			}
+			last->next_ = nullptr;
+			return first;
+		}
+
+		inline static void resume_all(waiter *w) noexcept {
+			while (w != nullptr) {
+				waiter *next = w->next_; // 恢复后 awaiter 可能随协程帧一起失效
+				detail::resume_waiter(w->pool_, w->handle_);
+				w = next;
+			}
+		}
+
+		lock::mutex<> mtx_;
+		u64 readers_ = 0;
+		bool writer_ = false;
+		waiter *head_ = nullptr;
+		waiter *tail_ = nullptr;
 	};
-} // namespace chenc
+} // namespace chenc::thread
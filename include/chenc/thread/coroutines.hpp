@@ -1,17 +1,369 @@
 #pragma once
 
-#include "chenc/core/cpu/relax.hpp"
+#include "chenc/core/cpp.hpp"
 #include "chenc/core/type.hpp"
+#include "chenc/thread/future.hpp"
+#include "chenc/thread/thread_pool.hpp"
 
-#include <array>
 #include <atomic>
-#include <bit>
-#include <chrono>
-#include <thread>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace chenc::thread {
+	namespace detail {
+		/**
+		 * @brief 协程帧分配器
+		 * 按缓存行粒度分成 16 个大小级（最大 1KB），每个线程一组空闲链表；
+		 * 帧可以在任意线程释放，归还到释放线程的链表，每级最多缓存 max_cached 个，超出的直接释放。
+		 * 更大的帧直接走 operator new。
+		 */
+		class frame_allocator {
+		public:
+			inline static constexpr u64 granule = CHENC_CACHE_LINE;
+			inline static constexpr u64 class_count = 16;
+			inline static constexpr u64 max_cached = 256;
+
+		private:
+			struct free_block {
+				free_block *next_;
+			};
+			struct bucket {
+				free_block *head_ = nullptr;
+				u64 count_ = 0;
+			};
+			struct thread_cache {
+				bucket buckets_[class_count];
+				bool alive_ = true;
+
+				~thread_cache() {
+					for (bucket &b : buckets_) {
+						while (b.head_ != nullptr) {
+							free_block *next = b.head_->next_;
+							::operator delete(b.head_, std::align_val_t{granule});
+							b.head_ = next;
+						}
+					}
+					alive_ = false;
+				}
+			};
+
+			inline static thread_cache &local() noexcept {
+				static thread_local thread_cache cache;
+				return cache;
+			}
+
+		public:
+			inline static void *allocate(u64 n) {
+				u64 c = (n + granule - 1) / granule;
+				if (c <= class_count) {
+					thread_cache &tc = local();
+					bucket &b = tc.buckets_[c - 1];
+					if (b.head_ != nullptr) [[likely]] {
+						free_block *p = b.head_;
+						b.head_ = p->next_;
+						b.count_--;
+						return p;
+					}
+					n = c * granule;
+				}
+				return ::operator new(n, std::align_val_t{granule});
+			}
+
+			inline static void deallocate(void *p, u64 n) noexcept {
+				u64 c = (n + granule - 1) / granule;
+				if (c <= class_count) {
+					thread_cache &tc = local();
+					bucket &b = tc.buckets_[c - 1];
+					if (tc.alive_ && b.count_ < max_cached) [[likely]] {
+						free_block *blk = static_cast<free_block *>(p);
+						blk->next_ = b.head_;
+						b.head_ = blk;
+						b.count_++;
+						return;
+					}
+				}
+				::operator delete(p, std::align_val_t{granule});
+			}
+		};
+
+		// 协程 promise 的公共基类：帧从 frame_allocator 分配
+		struct frame_alloc_base {
+			inline static void *operator new(std::size_t n) { return frame_allocator::allocate(n); }
+			inline static void operator delete(void *p, std::size_t n) noexcept { frame_allocator::deallocate(p, n); }
+		};
+
+		// 在线程池上恢复协程；句柄只占 8 字节，任务节点不分配内存
+		inline void resume_on(thread_pool &pool, std::coroutine_handle<> h) {
+			pool.post([h]() { h.resume(); });
+		}
+
+		/**
+		 * @brief 恢复一个等待者
+		 * 在它挂起时所在的线程池上恢复；挂起时不在线程池中、或线程池已停止时，直接在当前线程恢复
+		 */
+		inline void resume_waiter(thread_pool *pool, std::coroutine_handle<> h) noexcept {
+			if (pool != nullptr) {
+				try {
+					resume_on(*pool, h);
+					return;
+				} catch (...) {
+				}
+			}
+			h.resume();
+		}
+	} // namespace detail
+
+	template <typename T = void>
+	class co_task;
+
+	namespace detail {
+		// co_task 的 promise 公共部分：结束时对称转移回等待者
+		struct co_task_promise_base : frame_alloc_base {
+			struct final_awaiter {
+				inline bool await_ready() const noexcept { return false; }
+				template <typename P>
+				inline std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+					std::coroutine_handle<> next = h.promise().continuation_;
+					return next ? next : std::noop_coroutine();
+				}
+				inline void await_resume() const noexcept {}
+			};
+
+			inline std::suspend_always initial_suspend() const noexcept { return {}; }
+			inline final_awaiter final_suspend() const noexcept { return {}; }
+			inline void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+			std::coroutine_handle<> continuation_{};
+			std::exception_ptr exception_{};
+		};
+
+		template <typename T>
+		struct co_task_promise : co_task_promise_base {
+			co_task<T> get_return_object() noexcept;
+
+			template <typename U>
+			inline void return_value(U &&v) {
+				new (value_) T(std::forward<U>(v));
+				has_value_ = true;
+			}
+
+			inline T result() {
+				if (exception_) {
+					std::rethrow_exception(exception_);
+				}
+				return std::move(*std::launder(reinterpret_cast<T *>(value_)));
+			}
+
+			~co_task_promise() {
+				if (has_value_) {
+					std::launder(reinterpret_cast<T *>(value_))->~T();
+				}
+			}
+
+			alignas(T) std::byte value_[sizeof(T)];
+			bool has_value_ = false;
+		};
+
+		template <>
+		struct co_task_promise<void> : co_task_promise_base {
+			co_task<void> get_return_object() noexcept;
+
+			inline void return_void() const noexcept {}
+			inline void result() {
+				if (exception_) {
+					std::rethrow_exception(exception_);
+				}
+			}
+		};
+	} // namespace detail
+
+	/**
+	 * @brief 惰性协程任务
+	 * - 创建时不执行，被 co_await 时才开始；结束时对称转移回等待者，深层 co_await 链不会增长调用栈
+	 * - 协程帧来自 detail::frame_allocator
+	 * - 只能被 co_await 一次；异常在 co_await 处重新抛出
+	 */
+	template <typename T>
+	class co_task {
+	public:
+		using promise_type = detail::co_task_promise<T>;
+		using handle_type = std::coroutine_handle<promise_type>;
+
+		co_task() noexcept = default;
+		co_task(co_task &&other) noexcept
+			: handle_(std::exchange(other.handle_, nullptr)) {}
+		co_task &operator=(co_task &&other) noexcept {
+			if (this != &other) {
+				reset();
+				handle_ = std::exchange(other.handle_, nullptr);
+			}
+			return *this;
+		}
+		co_task(const co_task &) = delete;
+		co_task &operator=(const co_task &) = delete;
+
+		~co_task() { reset(); }
+
+		inline bool valid() const noexcept { return static_cast<bool>(handle_); }
+		inline bool done() const noexcept { return handle_ && handle_.done(); }
+
+		// 等待空的 co_task（默认构造或已被移走）抛出 std::logic_error
+		inline auto operator co_await() && {
+			if (!handle_) [[unlikely]] {
+				throw std::logic_error("co_task: awaiting an empty task");
+			}
+			struct awaiter {
+				handle_type h_;
+
+				inline bool await_ready() const noexcept { return h_.done(); }
+				inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+					h_.promise().continuation_ = caller;
+					return h_;
+				}
+				inline T await_resume() { return h_.promise().result(); }
+			};
+			return awaiter{handle_};
+		}
+
+		inline auto operator co_await() & { return std::move(*this).operator co_await(); }
+
+	private:
+		friend struct detail::co_task_promise<T>;
+		explicit co_task(handle_type h) noexcept
+			: handle_(h) {}
+
+		inline void reset() noexcept {
+			if (handle_) {
+				handle_.destroy();
+				handle_ = nullptr;
+			}
+		}
+
+		handle_type handle_{};
+	};
+
+	namespace detail {
+		template <typename T>
+		inline co_task<T> co_task_promise<T>::get_return_object() noexcept {
+			return co_task<T>(std::coroutine_handle<co_task_promise<T>>::from_promise(*this));
+		}
+
+		inline co_task<void> co_task_promise<void>::get_return_object() noexcept {
+			return co_task<void>(std::coroutine_handle<co_task_promise<void>>::from_promise(*this));
+		}
+
+		// 分离运行的协程：立即开始，结束时自行销毁帧
+		struct detached_coroutine {
+			struct promise_type : frame_alloc_base {
+				inline detached_coroutine get_return_object() const noexcept { return {}; }
+				inline std::suspend_never initial_suspend() const noexcept { return {}; }
+				inline std::suspend_never final_suspend() const noexcept { return {}; }
+				inline void return_void() const noexcept {}
+				inline void unhandled_exception() const noexcept { std::terminate(); }
+			};
+		};
+
+		// 先挂起、由调用方决定在哪里开始的分离协程，结束时自行销毁帧
+		struct deferred_coroutine {
+			struct promise_type : frame_alloc_base {
+				inline deferred_coroutine get_return_object() noexcept {
+					return {std::coroutine_handle<promise_type>::from_promise(*this)};
+				}
+				inline std::suspend_always initial_suspend() const noexcept { return {}; }
+				inline std::suspend_never final_suspend() const noexcept { return {}; }
+				inline void return_void() const noexcept {}
+				inline void unhandled_exception() const noexcept { std::terminate(); }
+			};
+
+			std::coroutine_handle<> handle_;
+		};
+	} // namespace detail
+
+	/**
+	 * @brief 切换到线程池执行
+	 * co_await schedule_on(pool) 之后，协程在 pool 的某个 worker 上恢复；
+	 * 在 worker 内调用时进入本地队列（相当于让出），线程池已停止时在 co_await 处抛出 std::runtime_error。
+	 */
+	inline auto schedule_on(thread_pool &pool) noexcept {
+		struct awaiter {
+			thread_pool &pool_;
+
+			inline bool await_ready() const noexcept { return false; }
+			inline void await_suspend(std::coroutine_handle<> h) { detail::resume_on(pool_, h); }
+			inline void await_resume() const noexcept {}
+		};
+		return awaiter{pool};
+	}
+
+	/**
+	 * @brief 协程调度器
+	 * 在工作窃取线程池上恢复协程：被恢复的协程像普通任务一样进入本地队列或注入通道，可被其他 worker 窃取。
+	 */
 	class coroutine_run_manager {
+	public:
+		explicit coroutine_run_manager(thread_pool &pool) noexcept
+			: pool_(pool) {}
+
+		inline thread_pool &pool() const noexcept { return pool_; }
+
+		// co_await schedule() 切换到本调度器
+		inline auto schedule() const noexcept { return schedule_on(pool_); }
+
+		// 在调度器上恢复一个挂起的协程
+		inline void resume(std::coroutine_handle<> h) const { detail::resume_on(pool_, h); }
+
+		/**
+		 * @brief 分离运行：t 在线程池上执行，结束后释放
+		 * t 抛出的异常会终止程序；线程池已停止时抛出 std::runtime_error，t 不会执行。
+		 */
+		inline void spawn(co_task<void> t) const {
+			std::coroutine_handle<> h = run_detached(std::move(t)).handle_;
+			try {
+				detail::resume_on(pool_, h);
+			} catch (...) {
+				h.destroy();
+				throw;
+			}
+		}
+
 	private:
-		std::array<>;
+		inline static detail::deferred_coroutine run_detached(co_task<void> t) {
+			co_await std::move(t);
+		}
+
+		thread_pool &pool_;
 	};
+
+	namespace detail {
+		template <typename T>
+		inline detached_coroutine sync_wait_driver(co_task<T> t, promise<T> p) {
+			try {
+				if constexpr (std::is_void_v<T>) {
+					co_await std::move(t);
+					p.set_value();
+				} else {
+					p.set_value(co_await std::move(t));
+				}
+			} catch (...) {
+				p.set_exception(std::current_exception());
+			}
+		}
+	} // namespace detail
+
+	/**
+	 * @brief 阻塞等待协程任务完成并返回结果
+	 * 任务在调用线程上开始，直到第一次切换线程；在线程池 worker 内调用时，等待期间会帮助执行其他任务。
+	 */
+	template <typename T>
+	inline T sync_wait(co_task<T> t) {
+		promise<T> p;
+		future<T> f = p.get_future();
+		detail::sync_wait_driver(std::move(t), std::move(p));
+		return f.get();
+	}
 } // namespace chenc::thread
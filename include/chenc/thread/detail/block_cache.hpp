@@ -0,0 +1,147 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/lock.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chenc::thread::detail {
+	/**
+	 * @brief 缓存行大小内存块的空闲链表
+	 * 任务节点、future 共享状态等固定 64 字节对象从这里分配，稳态下不再调用 malloc。
+	 * - 拥有者线程：无同步地操作 local_ 链表
+	 * - 其他线程释放：CAS 压入 remote_（只压不弹，无 ABA），拥有者在 local_ 为空时整体取走
+	 * - shared 模式：供非 worker 线程共用，local_ 由互斥锁保护
+	 * 块内存只在进程结束时释放：缓存由全局注册表租借给 worker，线程池销毁后归还复用，
+	 * 因此逃逸出线程池生命周期的 future 依然安全。
+	 */
+	class block_cache {
+	public:
+		inline static constexpr u64 block_size = CHENC_CACHE_LINE;
+		inline static constexpr u64 chunk_blocks = 64; // 每次补充的块数
+
+	private:
+		union alignas(CHENC_CACHE_LINE) block {
+			block *next_;
+			std::byte raw_[block_size];
+		};
+
+	public:
+		explicit block_cache(bool shared = false) noexcept
+			: shared_(shared) {}
+
+		block_cache(const block_cache &) = delete;
+		block_cache &operator=(const block_cache &) = delete;
+
+		// 分配一个块；只能由拥有者线程调用（shared 模式任意线程）
+		inline void *alloc() {
+			if (shared_) {
+				std::scoped_lock guard(mtx_);
+				return alloc_local();
+			}
+			return alloc_local();
+		}
+
+		// 释放一个由本缓存分配的块，任意线程可调用
+		inline void free(void *p) noexcept {
+			block *b = static_cast<block *>(p);
+			if (shared_) {
+				std::scoped_lock guard(mtx_);
+				b->next_ = local_;
+				local_ = b;
+			} else if (this_cache() == this) {
+				b->next_ = local_;
+				local_ = b;
+			} else {
+				block *head = remote_.load(std::memory_order_relaxed);
+				do {
+					b->next_ = head;
+				} while (!remote_.compare_exchange_weak(head, b,
+														std::memory_order_release,
+														std::memory_order_relaxed));
+			}
+		}
+
+		// 当前线程绑定的缓存（worker 线程），未绑定为 nullptr
+		inline static block_cache *&this_cache() noexcept {
+			static thread_local block_cache *cache = nullptr;
+			return cache;
+		}
+
+		// 非 worker 线程共用的缓存
+		inline static block_cache &shared_cache() noexcept {
+			static block_cache *cache = new block_cache(true); // 有意泄漏，避免静态析构顺序问题
+			return *cache;
+		}
+
+		// 当前线程应使用的缓存
+		inline static block_cache &current() noexcept {
+			block_cache *c = this_cache();
+			return c != nullptr ? *c : shared_cache();
+		}
+
+		// 从全局注册表租借一个缓存
+		inline static block_cache *lease() {
+			registry &r = get_registry();
+			std::scoped_lock guard(r.mtx_);
+			if (!r.idle_.empty()) {
+				block_cache *c = r.idle_.back();
+				r.idle_.pop_back();
+				return c;
+			}
+			r.all_.emplace_back(std::make_unique<block_cache>());
+			return r.all_.back().get();
+		}
+
+		// 归还缓存；调用线程不再作为其拥有者
+		inline static void release(block_cache *c) {
+			registry &r = get_registry();
+			std::scoped_lock guard(r.mtx_);
+			r.idle_.push_back(c);
+		}
+
+	private:
+		struct registry {
+			lock::mutex<> mtx_;
+			std::vector<std::unique_ptr<block_cache>> all_;
+			std::vector<block_cache *> idle_;
+		};
+		inline static registry &get_registry() {
+			static registry *r = new registry(); // 有意泄漏，块可能在静态析构期间仍被释放
+			return *r;
+		}
+
+		inline void *alloc_local() {
+			if (local_ == nullptr) [[unlikely]] {
+				local_ = remote_.exchange(nullptr, std::memory_order_acquire);
+				if (local_ == nullptr) {
+					refill();
+				}
+			}
+			block *b = local_;
+			local_ = b->next_;
+			return b;
+		}
+
+		CHENC_NO_INLINE void refill() {
+			std::unique_ptr<block[]> chunk(new block[chunk_blocks]);
+			for (u64 i = 0; i < chunk_blocks; ++i) {
+				chunk[i].next_ = i + 1 < chunk_blocks ? &chunk[i + 1] : nullptr;
+			}
+			local_ = &chunk[0];
+			chunks_.emplace_back(std::move(chunk));
+		}
+
+	private:
+		block *local_ = nullptr;
+		bool shared_ = false;
+		lock::mutex<> mtx_;
+		std::vector<std::unique_ptr<block[]>> chunks_;
+		CHENC_CACHE_ALIGN std::atomic<block *> remote_{nullptr};
+	};
+} // namespace chenc::thread::detail
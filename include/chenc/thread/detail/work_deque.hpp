@@ -0,0 +1,133 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace chenc::thread::detail {
+	/**
+	 * @brief Chase–Lev 工作窃取双端队列
+	 * 拥有者线程在 bottom 端 push/take（LIFO），其他线程在 top 端 steal（FIFO）。
+	 * 内存序参照 Lê et al. "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP'13)。
+	 * T 必须可平凡拷贝（通常为任务指针），槽位以 relaxed 原子读写，允许窃取者与扩容并发。
+	 */
+	template <typename T>
+	class work_deque {
+		static_assert(std::is_trivially_copyable_v<T>, "work_deque<T>: T must be trivially copyable");
+
+	private:
+		struct ring {
+			explicit ring(i64 capa)
+				: capa_(capa), mask_(capa - 1), data_(new std::atomic<T>[capa]) {}
+
+			inline T get(i64 i) const noexcept { return data_[i & mask_].load(std::memory_order_relaxed); }
+			inline void put(i64 i, T v) noexcept { data_[i & mask_].store(v, std::memory_order_relaxed); }
+
+			// 扩容：只由拥有者调用，拷贝 [t, b) 区间
+			inline ring *grow(i64 b, i64 t) const {
+				ring *r = new ring(capa_ * 2);
+				for (i64 i = t; i < b; ++i) {
+					r->put(i, get(i));
+				}
+				return r;
+			}
+
+			i64 capa_;
+			i64 mask_;
+			std::unique_ptr<std::atomic<T>[]> data_;
+		};
+
+	public:
+		explicit work_deque(u64 initial_capa = 256) {
+			ring *r = new ring(i64(std::bit_ceil(std::max<u64>(initial_capa, 2))));
+			rings_.emplace_back(r);
+			ring_.store(r, std::memory_order_relaxed);
+		}
+
+		work_deque(const work_deque &) = delete;
+		work_deque &operator=(const work_deque &) = delete;
+
+		// --- 拥有者入队 ---
+		inline void push(T v) {
+			i64 b = bottom_.load(std::memory_order_relaxed);
+			i64 t = top_.load(std::memory_order_acquire);
+			ring *r = ring_.load(std::memory_order_relaxed);
+			if (b - t > r->capa_ - 1) [[unlikely]] {
+				// 旧 ring 保留到析构，窃取者可能仍在读取
+				r = r->grow(b, t);
+				rings_.emplace_back(r);
+				ring_.store(r, std::memory_order_release);
+			}
+			r->put(b, v);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom_.store(b + 1, std::memory_order_relaxed);
+		}
+
+		// --- 拥有者出队（LIFO） ---
+		inline std::optional<T> take() noexcept {
+			i64 b = bottom_.load(std::memory_order_relaxed) - 1;
+			ring *r = ring_.load(std::memory_order_relaxed);
+			bottom_.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			i64 t = top_.load(std::memory_order_relaxed);
+
+			if (t > b) {
+				// 队列为空，恢复 bottom
+				bottom_.store(b + 1, std::memory_order_relaxed);
+				return std::nullopt;
+			}
+			T v = r->get(b);
+			if (t == b) {
+				// 最后一个元素：与窃取者竞争 top
+				bool won = top_.compare_exchange_strong(t, t + 1,
+														std::memory_order_seq_cst,
+														std::memory_order_relaxed);
+				bottom_.store(b + 1, std::memory_order_relaxed);
+				if (!won) {
+					return std::nullopt;
+				}
+			}
+			return v;
+		}
+
+		// --- 其他线程窃取（FIFO） ---
+		inline std::optional<T> steal() noexcept {
+			i64 t = top_.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			i64 b = bottom_.load(std::memory_order_acquire);
+			if (t >= b) {
+				return std::nullopt;
+			}
+			ring *r = ring_.load(std::memory_order_acquire);
+			T v = r->get(t);
+			if (!top_.compare_exchange_strong(t, t + 1,
+											  std::memory_order_seq_cst,
+											  std::memory_order_relaxed)) {
+				return std::nullopt;
+			}
+			return v;
+		}
+
+		// 元素数（非严格一致）
+		inline u64 size() const noexcept {
+			i64 b = bottom_.load(std::memory_order_relaxed);
+			i64 t = top_.load(std::memory_order_relaxed);
+			return b > t ? u64(b - t) : 0;
+		}
+
+		inline bool empty() const noexcept { return size() == 0; }
+
+	private:
+		CHENC_CACHE_ALIGN std::atomic<i64> top_{0};	   // 窃取端
+		CHENC_CACHE_ALIGN std::atomic<i64> bottom_{0}; // 拥有者端
+		CHENC_CACHE_ALIGN std::atomic<ring *> ring_{nullptr};
+		std::vector<std::unique_ptr<ring>> rings_; // 全部 ring，仅拥有者修改
+	};
+} // namespace chenc::thread::detail
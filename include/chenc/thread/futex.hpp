@@ -0,0 +1,128 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+#if defined(__linux__)
+#	include <cerrno>
+#	include <ctime>
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+namespace chenc::thread {
+	/**
+	 * @brief 32 位原子字上的等待 / 唤醒
+	 * std::atomic::wait 没有超时，这里在 Linux 上直接使用 futex：
+	 * - 等待使用 FUTEX_WAIT_BITSET_PRIVATE，超时为 CLOCK_MONOTONIC（即 steady_clock）上的绝对时间，
+	 *   被信号打断或虚假唤醒后重试时不需要重新计算剩余时长
+	 * - 唤醒使用 FUTEX_WAKE_PRIVATE
+	 * 同一个字上的等待和唤醒必须都经过这里：libstdc++ 的 notify_one 只在有经由 atomic::wait
+	 * 登记的等待者时才发起系统调用，唤醒不了直接 futex 等待的线程。
+	 * 其他平台：无超时的等待 / 唤醒退化为 std::atomic::wait / notify，带超时的等待退化为退避轮询。
+	 */
+	using futex_clock = std::chrono::steady_clock;
+
+	static_assert(sizeof(std::atomic<u32>) == sizeof(u32) && std::atomic<u32>::is_always_lock_free);
+
+#if defined(__linux__)
+	namespace detail {
+		CHENC_FORCE_INLINE long futex(std::atomic<u32> &word, int op, u32 val, const timespec *ts, u32 val3) noexcept {
+			return ::syscall(SYS_futex, reinterpret_cast<u32 *>(&word), op, val, ts, nullptr, val3);
+		}
+	} // namespace detail
+
+	// 值等于 expected 时挂起，直到被唤醒（可能虚假唤醒，调用方须重新检查条件）
+	inline void futex_wait(std::atomic<u32> &word, u32 expected) noexcept {
+		detail::futex(word, FUTEX_WAIT_BITSET_PRIVATE, expected, nullptr, FUTEX_BITSET_MATCH_ANY);
+	}
+
+	/**
+	 * @brief 值等于 expected 时挂起，最多到 deadline
+	 * @return 到达 deadline 返回 false；被唤醒、值已改变或虚假唤醒返回 true
+	 */
+	inline bool futex_wait_until(std::atomic<u32> &word, u32 expected, futex_clock::time_point deadline) noexcept {
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+		if (ns <= 0) {
+			return false;
+		}
+		timespec ts{.tv_sec = time_t(ns / 1'000'000'000), .tv_nsec = long(ns % 1'000'000'000)};
+		if (detail::futex(word, FUTEX_WAIT_BITSET_PRIVATE, expected, &ts, FUTEX_BITSET_MATCH_ANY) == -1 &&
+			errno == ETIMEDOUT) {
+			return false;
+		}
+		return true;
+	}
+
+	inline void futex_wake_one(std::atomic<u32> &word) noexcept {
+		detail::futex(word, FUTEX_WAKE_PRIVATE, 1, nullptr, 0);
+	}
+
+	inline void futex_wake_all(std::atomic<u32> &word) noexcept {
+		detail::futex(word, FUTEX_WAKE_PRIVATE, u32(INT32_MAX), nullptr, 0);
+	}
+
+	/**
+	 * @brief 优先级继承 futex：字中存放持有者 TID，竞争时内核置 FUTEX_WAITERS 位
+	 * 由内核完成排队与持有者的优先级提升；返回 0 表示已获取，否则为 errno
+	 */
+	inline int futex_lock_pi(std::atomic<u32> &word) noexcept {
+		return detail::futex(word, FUTEX_LOCK_PI_PRIVATE, 0, nullptr, 0) == 0 ? 0 : errno;
+	}
+
+	// 释放优先级继承 futex 并把所有权交给最高优先级的等待者
+	inline int futex_unlock_pi(std::atomic<u32> &word) noexcept {
+		return detail::futex(word, FUTEX_UNLOCK_PI_PRIVATE, 0, nullptr, 0) == 0 ? 0 : errno;
+	}
+
+	// 内核线程 ID（优先级继承 futex 的持有者标识）
+	inline u32 this_tid() noexcept {
+		static thread_local const u32 tid = u32(::syscall(SYS_gettid));
+		return tid;
+	}
+#else
+	inline void futex_wait(std::atomic<u32> &word, u32 expected) noexcept {
+		word.wait(expected, std::memory_order_relaxed);
+	}
+
+	inline bool futex_wait_until(std::atomic<u32> &word, u32 expected, futex_clock::time_point deadline) noexcept {
+		auto step = std::chrono::microseconds(1);
+		while (word.load(std::memory_order_relaxed) == expected) {
+			auto now = futex_clock::now();
+			if (now >= deadline) {
+				return false;
+			}
+			std::this_thread::sleep_for(std::min<futex_clock::duration>(step, deadline - now));
+			step = std::min(step * 2, std::chrono::microseconds(1000));
+		}
+		return true;
+	}
+
+	inline void futex_wake_one(std::atomic<u32> &word) noexcept { word.notify_one(); }
+	inline void futex_wake_all(std::atomic<u32> &word) noexcept { word.notify_all(); }
+#endif
+
+	// 任意时钟的时间点换算为 futex_clock 上的截止时间（向上取整）
+	template <typename Clock, typename Duration>
+	inline futex_clock::time_point to_futex_deadline(const std::chrono::time_point<Clock, Duration> &t) noexcept {
+		if constexpr (std::is_same_v<Clock, futex_clock>) {
+			return std::chrono::ceil<futex_clock::duration>(t);
+		} else {
+			return futex_clock::now() + std::chrono::ceil<futex_clock::duration>(t - Clock::now());
+		}
+	}
+
+	// 从现在起 timeout 之后的截止时间
+	template <typename Rep, typename Period>
+	inline futex_clock::time_point futex_deadline_after(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+		return futex_clock::now() + std::chrono::ceil<futex_clock::duration>(timeout);
+	}
+} // namespace chenc::thread
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/detail/block_cache.hpp"
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <future>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace chenc::thread {
+	namespace detail {
+		/**
+		 * @brief 当前线程的“帮助执行”钩子
+		 * 线程池 worker 设置此钩子，future::wait 在阻塞前先用它执行其他待处理任务，
+		 * 使 worker 内部等待子任务结果时不会占着线程空等。
+		 */
+		struct worker_hook {
+			void *ctx_ = nullptr;
+			bool (*run_one_)(void *ctx) = nullptr;
+
+			inline static worker_hook &current() noexcept {
+				static thread_local worker_hook hook;
+				return hook;
+			}
+		};
+
+		// 共享状态公共部分
+		struct future_state_base {
+			enum status : u32 { pending = 0,
+								value = 1,
+								error = 2 };
+
+			std::atomic<u32> status_{pending};
+			std::atomic<u32> refs_{2};		 // promise + future
+			block_cache *owner_ = nullptr;	 // nullptr 表示堆分配
+			std::exception_ptr exception_{}; // 仅 error 状态有效
+
+			inline bool ready() const noexcept {
+				return status_.load(std::memory_order_acquire) != pending;
+			}
+
+			inline void wait() const {
+				if (ready()) [[likely]]
+					return;
+				// worker 线程：先帮助执行其他任务
+				worker_hook &hook = worker_hook::current();
+				if (hook.run_one_ != nullptr) {
+					while (!ready()) {
+						if (!hook.run_one_(hook.ctx_)) {
+							break;
+						}
+					}
+				}
+				while (status_.load(std::memory_order_acquire) == pending) {
+					status_.wait(pending, std::memory_order_acquire);
+				}
+			}
+
+			inline void publish(status s) noexcept {
+				status_.store(s, std::memory_order_release);
+				status_.notify_all();
+			}
+		};
+
+		template <typename T>
+		struct future_state : future_state_base {
+			alignas(T) std::byte value_[sizeof(T)];
+
+			inline T *get_ptr() noexcept { return reinterpret_cast<T *>(value_); }
+			inline void destroy_value() noexcept {
+				if (status_.load(std::memory_order_relaxed) == value) {
+					get_ptr()->~T();
+				}
+			}
+		};
+
+		template <>
+		struct future_state<void> : future_state_base {
+			inline void destroy_value() noexcept {}
+		};
+
+		// 能放进一个缓存块的共享状态从空闲链表分配，否则走堆
+		template <typename T>
+		inline future_state<T> *make_future_state() {
+			using S = future_state<T>;
+			if constexpr (sizeof(S) <= block_cache::block_size && alignof(S) <= block_cache::block_size) {
+				block_cache &cache = block_cache::current();
+				S *s = new (cache.alloc()) S();
+				s->owner_ = &cache;
+				return s;
+			} else {
+				return new S();
+			}
+		}
+
+		template <typename T>
+		inline void release_future_state(future_state<T> *s) noexcept {
+			if (s->refs_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+				return;
+			}
+			s->destroy_value();
+			block_cache *owner = s->owner_;
+			if (owner != nullptr) {
+				s->~future_state<T>();
+				owner->free(s);
+			} else {
+				delete s;
+			}
+		}
+	} // namespace detail
+
+	template <typename T>
+	class promise;
+
+	/**
+	 * @brief 轻量 future
+	 * 共享状态来自当前线程的缓存块空闲链表；get() 只能调用一次。
+	 */
+	template <typename T>
+	class future {
+	public:
+		future() noexcept = default;
+		future(future &&other) noexcept
+			: state_(std::exchange(other.state_, nullptr)) {}
+		future &operator=(future &&other) noexcept {
+			if (this != &other) {
+				reset();
+				state_ = std::exchange(other.state_, nullptr);
+			}
+			return *this;
+		}
+		future(const future &) = delete;
+		future &operator=(const future &) = delete;
+
+		~future() { reset(); }
+
+		inline bool valid() const noexcept { return state_ != nullptr; }
+		inline bool ready() const noexcept { return state_ != nullptr && state_->ready(); }
+
+		// 等待结果就绪；worker 线程中等待期间会帮助执行其他任务
+		inline void wait() const { state_->wait(); }
+
+		inline T get() {
+			state_->wait();
+			detail::future_state<T> *s = std::exchange(state_, nullptr);
+			struct guard_t {
+				detail::future_state<T> *s_;
+				~guard_t() { detail::release_future_state(s_); }
+			} guard{s};
+
+			if (s->status_.load(std::memory_order_acquire) == detail::future_state_base::error) {
+				std::rethrow_exception(s->exception_);
+			}
+			if constexpr (!std::is_void_v<T>) {
+				return std::move(*s->get_ptr());
+			}
+		}
+
+	private:
+		friend class promise<T>;
+		explicit future(detail::future_state<T> *s) noexcept
+			: state_(s) {}
+
+		inline void reset() noexcept {
+			if (state_ != nullptr) {
+				detail::release_future_state(std::exchange(state_, nullptr));
+			}
+		}
+
+		detail::future_state<T> *state_ = nullptr;
+	};
+
+	/**
+	 * @brief 轻量 promise
+	 * 未设置结果就被销毁时，future 会收到 std::future_errc::broken_promise。
+	 */
+	template <typename T>
+	class promise {
+	public:
+		promise()
+			: state_(detail::make_future_state<T>()) {}
+		promise(promise &&other) noexcept
+			: state_(std::exchange(other.state_, nullptr)),
+			  retrieved_(other.retrieved_) {}
+		promise &operator=(promise &&other) noexcept {
+			if (this != &other) {
+				abandon();
+				state_ = std::exchange(other.state_, nullptr);
+				retrieved_ = other.retrieved_;
+			}
+			return *this;
+		}
+		promise(const promise &) = delete;
+		promise &operator=(const promise &) = delete;
+
+		~promise() { abandon(); }
+
+		// 只能调用一次
+		inline future<T> get_future() noexcept {
+			retrieved_ = true;
+			return future<T>(state_);
+		}
+
+		template <typename... Args>
+		inline void set_value(Args &&...args) {
+			if constexpr (!std::is_void_v<T>) {
+				new (state_->get_ptr()) T(std::forward<Args>(args)...);
+			}
+			state_->publish(detail::future_state_base::value);
+			detach();
+		}
+
+		inline void set_exception(std::exception_ptr e) noexcept {
+			state_->exception_ = std::move(e);
+			state_->publish(detail::future_state_base::error);
+			detach();
+		}
+
+		// 调用 f 并将返回值或异常写入共享状态
+		template <typename F, typename... Args>
+		inline void set_from(F &&f, Args &&...args) noexcept {
+			try {
+				if constexpr (std::is_void_v<T>) {
+					std::invoke(std::forward<F>(f), std::forward<Args>(args)...);
+					set_value();
+				} else {
+					set_value(std::invoke(std::forward<F>(f), std::forward<Args>(args)...));
+				}
+			} catch (...) {
+				set_exception(std::current_exception());
+			}
+		}
+
+	private:
+		inline void detach() noexcept {
+			detail::future_state<T> *s = std::exchange(state_, nullptr);
+			if (!retrieved_) {
+				// 没有 future：共享状态只剩 promise 一方持有
+				s->refs_.fetch_sub(1, std::memory_order_relaxed);
+			}
+			detail::release_future_state(s);
+		}
+
+		inline void abandon() noexcept {
+			if (state_ != nullptr) {
+				set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+			}
+		}
+
+		detail::future_state<T> *state_ = nullptr;
+		bool retrieved_ = false;
+	};
+} // namespace chenc::thread
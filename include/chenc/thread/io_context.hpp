@@ -0,0 +1,904 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/atomic_queue.hpp"
+#include "chenc/thread/coroutines.hpp"
+#include "chenc/thread/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#	include <linux/io_uring.h>
+#	include <sys/epoll.h>
+#	include <sys/eventfd.h>
+#	include <sys/mman.h>
+#	include <sys/socket.h>
+#	include <sys/syscall.h>
+#	include <sys/uio.h>
+#	include <unistd.h>
+#endif
+
+#if defined(__linux__)
+namespace chenc::thread {
+	// I/O 后端
+	enum class io_backend : u8 {
+		automatic, // 优先 io_uring，不可用时退化为 epoll
+		uring,	   // 只使用 io_uring，不可用时构造失败
+		epoll	   // 只使用 epoll
+	};
+
+	// I/O 上下文配置
+	struct io_config {
+		u32 entries_ = 256; // io_uring 提交队列长度；每轮最多提交这么多个请求
+		io_backend backend_ = io_backend::automatic;
+	};
+
+	// 通过 io_context::register_files 注册的文件，按下标引用
+	struct fixed_file {
+		u32 index_;
+	};
+
+	// 普通 fd 或已注册文件
+	struct io_file {
+		io_file(int fd) noexcept
+			: fd_(fd), fixed_(false) {}
+		io_file(fixed_file f) noexcept
+			: fd_(int(f.index_)), fixed_(true) {}
+
+		int fd_;
+		bool fixed_;
+	};
+
+	namespace detail {
+		enum class io_opcode : u8 {
+			read,
+			write,
+			accept,
+			recv,
+			send
+		};
+
+		// 一次 I/O 请求；存放在 awaiter（即协程帧）中，提交不分配内存
+		struct io_op {
+			io_op *prev_ = nullptr; // 反应器线程上的链表（在途 / 等待就绪）
+			io_op *next_ = nullptr;
+			io_opcode opcode_ = io_opcode::read;
+			bool fixed_file_ = false;
+			bool fixed_buf_ = false;
+			bool cancel_sent_ = false;
+			u16 buf_index_ = 0;
+			int fd_ = -1;
+			int flags_ = 0;
+			u32 len_ = 0;
+			void *buf_ = nullptr;
+			u64 offset_ = u64(-1);
+			i64 result_ = 0;
+			std::coroutine_handle<> handle_{};
+		};
+
+		// 反应器线程私有的侵入式双向链表
+		struct io_op_list {
+			io_op *head_ = nullptr;
+			io_op *tail_ = nullptr;
+
+			inline bool empty() const noexcept { return head_ == nullptr; }
+
+			inline void push_back(io_op *op) noexcept {
+				op->next_ = nullptr;
+				op->prev_ = tail_;
+				(tail_ != nullptr ? tail_->next_ : head_) = op;
+				tail_ = op;
+			}
+
+			inline void erase(io_op *op) noexcept {
+				(op->prev_ != nullptr ? op->prev_->next_ : head_) = op->next_;
+				(op->next_ != nullptr ? op->next_->prev_ : tail_) = op->prev_;
+				op->prev_ = nullptr;
+				op->next_ = nullptr;
+			}
+
+			inline io_op *pop_front() noexcept {
+				io_op *op = head_;
+				if (op != nullptr) {
+					erase(op);
+				}
+				return op;
+			}
+		};
+
+		/**
+		 * @brief io_uring 环（直接使用系统调用，不依赖 liburing）
+		 * 只由反应器线程访问；register_* 由内核保证与提交并发安全。
+		 */
+		class uring {
+		public:
+			uring() noexcept = default;
+			uring(const uring &) = delete;
+			uring &operator=(const uring &) = delete;
+
+			~uring() { close(); }
+
+			// 建立环并探测所需操作；失败时返回 false（errno 保留原因）
+			bool open(u32 entries) noexcept {
+				io_uring_params p;
+				std::memset(&p, 0, sizeof(p));
+				p.flags = IORING_SETUP_CLAMP;
+				fd_ = int(::syscall(__NR_io_uring_setup, entries, &p));
+				if (fd_ < 0) {
+					fd_ = -1;
+					return false;
+				}
+				sq_size_ = p.sq_off.array + p.sq_entries * sizeof(u32);
+				cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+				bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+				if (single) {
+					sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+				}
+				sq_ptr_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+				if (sq_ptr_ == MAP_FAILED) {
+					sq_ptr_ = nullptr;
+					close();
+					return false;
+				}
+				if (single) {
+					cq_ptr_ = sq_ptr_;
+				} else {
+					cq_ptr_ = ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+					if (cq_ptr_ == MAP_FAILED) {
+						cq_ptr_ = nullptr;
+						close();
+						return false;
+					}
+				}
+				sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+				void *sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+				if (sqes == MAP_FAILED) {
+					close();
+					return false;
+				}
+				sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+				auto *sq = static_cast<std::byte *>(sq_ptr_);
+				auto *cq = static_cast<std::byte *>(cq_ptr_);
+				sq_head_ = reinterpret_cast<u32 *>(sq + p.sq_off.head);
+				sq_tail_ = reinterpret_cast<u32 *>(sq + p.sq_off.tail);
+				sq_mask_ = *reinterpret_cast<u32 *>(sq + p.sq_off.ring_mask);
+				sq_entries_ = p.sq_entries;
+				cq_head_ = reinterpret_cast<u32 *>(cq + p.cq_off.head);
+				cq_tail_ = reinterpret_cast<u32 *>(cq + p.cq_off.tail);
+				cq_mask_ = *reinterpret_cast<u32 *>(cq + p.cq_off.ring_mask);
+				cq_entries_ = p.cq_entries;
+				cqes_ = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+
+				// SQ 索引数组固定为恒等映射
+				u32 *array = reinterpret_cast<u32 *>(sq + p.sq_off.array);
+				for (u32 i = 0; i < sq_entries_; ++i) {
+					array[i] = i;
+				}
+				local_tail_ = *sq_tail_;
+
+				if (!probe()) {
+					close();
+					errno = ENOSYS;
+					return false;
+				}
+				return true;
+			}
+
+			void close() noexcept {
+				if (sqes_ != nullptr) {
+					::munmap(sqes_, sqes_size_);
+					sqes_ = nullptr;
+				}
+				if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+					::munmap(cq_ptr_, cq_size_);
+				}
+				cq_ptr_ = nullptr;
+				if (sq_ptr_ != nullptr) {
+					::munmap(sq_ptr_, sq_size_);
+					sq_ptr_ = nullptr;
+				}
+				if (fd_ >= 0) {
+					::close(fd_);
+					fd_ = -1;
+				}
+			}
+
+			inline u32 cq_entries() const noexcept { return cq_entries_; }
+
+			// 取一个空闲 SQE（已清零）；提交队列剩余不超过 keep 个时返回 nullptr
+			inline io_uring_sqe *get_sqe(u32 keep = 0) noexcept {
+				u32 head = std::atomic_ref<u32>(*sq_head_).load(std::memory_order_acquire);
+				if (local_tail_ - head + keep >= sq_entries_) {
+					return nullptr;
+				}
+				io_uring_sqe *sqe = &sqes_[local_tail_ & sq_mask_];
+				std::memset(sqe, 0, sizeof(*sqe));
+				local_tail_++;
+				return sqe;
+			}
+
+			/**
+			 * @brief 发布本轮填好的 SQE，一次系统调用提交并等待至少 wait_nr 个完成
+			 * @return 0 或 -errno
+			 */
+			inline int enter(u32 wait_nr) noexcept {
+				std::atomic_ref<u32>(*sq_tail_).store(local_tail_, std::memory_order_release);
+				u32 to_submit = local_tail_ - std::atomic_ref<u32>(*sq_head_).load(std::memory_order_acquire);
+				if (to_submit == 0 && wait_nr == 0) {
+					return 0;
+				}
+				long r = ::syscall(__NR_io_uring_enter, fd_, to_submit, wait_nr,
+								   wait_nr != 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+				return r < 0 ? -errno : 0;
+			}
+
+			inline bool cq_empty() const noexcept {
+				return *cq_head_ == std::atomic_ref<u32>(*cq_tail_).load(std::memory_order_acquire);
+			}
+
+			// 依次处理已完成的 CQE
+			template <class F>
+			inline u32 reap(F &&f) {
+				u32 head = *cq_head_;
+				u32 tail = std::atomic_ref<u32>(*cq_tail_).load(std::memory_order_acquire);
+				u32 n = tail - head;
+				for (; head != tail; ++head) {
+					const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+					u64 data = cqe.user_data;
+					i32 res = cqe.res;
+					std::atomic_ref<u32>(*cq_head_).store(head + 1, std::memory_order_release);
+					f(data, res);
+				}
+				return n;
+			}
+
+			inline int do_register(unsigned opcode, const void *arg, unsigned nr) noexcept {
+				long r = ::syscall(__NR_io_uring_register, fd_, opcode, arg, nr);
+				return r < 0 ? -errno : 0;
+			}
+
+		private:
+			// 确认内核支持本文件用到的全部操作（READ / SEND 等需要 5.6+）
+			inline bool probe() noexcept {
+				constexpr u32 op_count = IORING_OP_LAST;
+				u64 bytes = sizeof(io_uring_probe) + op_count * sizeof(io_uring_probe_op);
+				std::unique_ptr<u64[]> buf(new (std::nothrow) u64[(bytes + 7) / 8]());
+				if (!buf) {
+					return false;
+				}
+				auto *pr = reinterpret_cast<io_uring_probe *>(buf.get());
+				if (do_register(IORING_REGISTER_PROBE, pr, op_count) != 0) {
+					return false;
+				}
+				for (u32 op : {u32(IORING_OP_READ), u32(IORING_OP_WRITE), u32(IORING_OP_READ_FIXED),
+							   u32(IORING_OP_WRITE_FIXED), u32(IORING_OP_ACCEPT), u32(IORING_OP_RECV),
+							   u32(IORING_OP_SEND), u32(IORING_OP_ASYNC_CANCEL)}) {
+					if (op > pr->last_op || (pr->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			int fd_ = -1;
+			void *sq_ptr_ = nullptr;
+			void *cq_ptr_ = nullptr;
+			u64 sq_size_ = 0;
+			u64 cq_size_ = 0;
+			u64 sqes_size_ = 0;
+			io_uring_sqe *sqes_ = nullptr;
+			u32 *sq_head_ = nullptr;
+			u32 *sq_tail_ = nullptr;
+			u32 sq_mask_ = 0;
+			u32 sq_entries_ = 0;
+			u32 local_tail_ = 0;
+			u32 *cq_head_ = nullptr;
+			u32 *cq_tail_ = nullptr;
+			u32 cq_mask_ = 0;
+			u32 cq_entries_ = 0;
+			io_uring_cqe *cqes_ = nullptr;
+		};
+	} // namespace detail
+
+	/**
+	 * @brief 协程异步 I/O（Linux）
+	 * - 后端为 io_uring（直接系统调用），不可用时退化为 epoll
+	 * - co_await 返回 i64：成功时为字节数（accept 为新 fd），失败时为 -errno
+	 * - 请求对象位于协程帧内，提交只是一次无锁入队；独立的反应器线程每轮把积攒的请求
+	 *   一次性写入提交队列，用一次 io_uring_enter 提交并收割完成
+	 * - 完成的协程通过 resume_on 回到线程池上恢复
+	 * - 支持注册缓冲区（read_fixed / write_fixed）和注册文件（fixed_file）；epoll 后端下两者只做下标映射
+	 * epoll 后端对 pipe / socket 先等待就绪再读写，对普通文件直接同步读写；
+	 * 该后端下的 fd 最好设为非阻塞，否则超过管道余量的 write 会阻塞反应器线程。
+	 * 必须在线程池之前销毁；销毁时未完成的请求以 -ECANCELED 结束。
+	 */
+	class io_context {
+	public:
+		// 读写当前文件位置（pipe / socket 必须使用）
+		inline static constexpr u64 current_pos = u64(-1);
+
+	private:
+		using op = detail::io_op;
+		using opcode = detail::io_opcode;
+
+		// CQE user_data 中的保留值
+		inline static constexpr u64 wake_tag = 0;
+		inline static constexpr u64 cancel_tag = 1;
+
+		// epoll 后端的 fd 状态；读方向和写方向各自 FIFO
+		struct fd_state {
+			int fd_ = -1;
+			detail::io_op_list readers_;
+			detail::io_op_list writers_;
+		};
+
+	public:
+		class op_awaiter {
+		public:
+			inline bool await_ready() const noexcept { return false; }
+			inline void await_suspend(std::coroutine_handle<> h) {
+				op_.handle_ = h;
+				ctx_.submit(&op_);
+			}
+			inline i64 await_resume() const noexcept { return op_.result_; }
+
+		private:
+			friend class io_context;
+			explicit op_awaiter(io_context &ctx) noexcept
+				: ctx_(ctx) {}
+
+			io_context &ctx_;
+			op op_{};
+		};
+
+	public:
+		explicit io_context(thread_pool &pool, const io_config &config = {})
+			: pool_(pool) {
+			wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+			if (wake_fd_ < 0) {
+				throw std::system_error(errno, std::system_category(), "io_context: eventfd");
+			}
+			if (config.backend_ != io_backend::epoll) {
+				if (ring_.open(std::max<u32>(config.entries_, 1))) {
+					backend_ = io_backend::uring;
+				} else if (config.backend_ == io_backend::uring) {
+					int err = errno;
+					::close(wake_fd_);
+					throw std::system_error(err, std::system_category(), "io_context: io_uring_setup");
+				}
+			}
+			if (backend_ != io_backend::uring) {
+				backend_ = io_backend::epoll;
+				epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+				epoll_event ev{};
+				ev.events = EPOLLIN;
+				ev.data.ptr = nullptr;
+				if (epoll_fd_ < 0 || ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) != 0) {
+					int err = errno;
+					if (epoll_fd_ >= 0) {
+						::close(epoll_fd_);
+					}
+					::close(wake_fd_);
+					throw std::system_error(err, std::system_category(), "io_context: epoll");
+				}
+			}
+			reactor_ = std::thread(&io_context::reactor_loop, this);
+		}
+
+		io_context(const io_context &) = delete;
+		io_context &operator=(const io_context &) = delete;
+
+		~io_context() {
+			stop_.store(true, std::memory_order_seq_cst);
+			wake();
+			reactor_.join();
+			// 反应器退出后才入队的请求
+			while (std::optional<op *> o = queue_.pop()) {
+				complete(*o, -ECANCELED);
+			}
+			ring_.close();
+			if (epoll_fd_ >= 0) {
+				::close(epoll_fd_);
+			}
+			::close(wake_fd_);
+		}
+
+		inline io_backend backend() const noexcept { return backend_; }
+		inline thread_pool &pool() const noexcept { return pool_; }
+
+		// ============================
+		// 请求
+		// ============================
+
+		// 读到 buf；offset 为 current_pos 时读写当前文件位置
+		[[nodiscard]] inline op_awaiter read(io_file f, std::span<std::byte> buf, u64 offset = current_pos) noexcept {
+			return make(opcode::read, f, buf.data(), buf.size(), offset, 0);
+		}
+
+		[[nodiscard]] inline op_awaiter write(io_file f, std::span<const std::byte> buf, u64 offset = current_pos) noexcept {
+			return make(opcode::write, f, const_cast<std::byte *>(buf.data()), buf.size(), offset, 0);
+		}
+
+		// 使用注册缓冲区 buf_index 的读写；buf 必须落在该缓冲区内
+		[[nodiscard]] inline op_awaiter read_fixed(io_file f, std::span<std::byte> buf, u16 buf_index,
+												   u64 offset = current_pos) noexcept {
+			op_awaiter a = make(opcode::read, f, buf.data(), buf.size(), offset, 0);
+			a.op_.fixed_buf_ = true;
+			a.op_.buf_index_ = buf_index;
+			return a;
+		}
+
+		[[nodiscard]] inline op_awaiter write_fixed(io_file f, std::span<const std::byte> buf, u16 buf_index,
+													u64 offset = current_pos) noexcept {
+			op_awaiter a = make(opcode::write, f, const_cast<std::byte *>(buf.data()), buf.size(), offset, 0);
+			a.op_.fixed_buf_ = true;
+			a.op_.buf_index_ = buf_index;
+			return a;
+		}
+
+		// 接受连接，返回新 fd（带 SOCK_CLOEXEC）
+		[[nodiscard]] inline op_awaiter accept(io_file f) noexcept {
+			return make(opcode::accept, f, nullptr, 0, 0, SOCK_CLOEXEC);
+		}
+
+		[[nodiscard]] inline op_awaiter recv(io_file f, std::span<std::byte> buf, int flags = 0) noexcept {
+			return make(opcode::recv, f, buf.data(), buf.size(), 0, flags);
+		}
+
+		[[nodiscard]] inline op_awaiter send(io_file f, std::span<const std::byte> buf, int flags = 0) noexcept {
+			return make(opcode::send, f, const_cast<std::byte *>(buf.data()), buf.size(), 0, flags);
+		}
+
+		// ============================
+		// 注册资源
+		// ============================
+
+		/**
+		 * @brief 注册固定缓冲区（io_uring 下免去每次请求的页锁定与映射）
+		 * 应在没有在途请求时调用；已有注册时先 unregister_buffers
+		 */
+		bool register_buffers(std::span<const iovec> bufs) noexcept {
+			if (backend_ == io_backend::uring &&
+				ring_.do_register(IORING_REGISTER_BUFFERS, bufs.data(), unsigned(bufs.size())) != 0) {
+				return false;
+			}
+			buffer_count_ = bufs.size();
+			return true;
+		}
+
+		bool unregister_buffers() noexcept {
+			if (backend_ == io_backend::uring && ring_.do_register(IORING_UNREGISTER_BUFFERS, nullptr, 0) != 0) {
+				return false;
+			}
+			buffer_count_ = 0;
+			return true;
+		}
+
+		/**
+		 * @brief 注册文件表，之后可以用 fixed_file{下标} 代替 fd（io_uring 下免去每次请求的 fd 查找）
+		 * 应在没有在途请求时调用
+		 */
+		bool register_files(std::span<const int> fds) {
+			if (backend_ == io_backend::uring &&
+				ring_.do_register(IORING_REGISTER_FILES, fds.data(), unsigned(fds.size())) != 0) {
+				return false;
+			}
+			files_.assign(fds.begin(), fds.end());
+			return true;
+		}
+
+		bool unregister_files() noexcept {
+			if (backend_ == io_backend::uring && ring_.do_register(IORING_UNREGISTER_FILES, nullptr, 0) != 0) {
+				return false;
+			}
+			files_.clear();
+			return true;
+		}
+
+	private:
+		inline op_awaiter make(opcode code, io_file f, std::byte *buf, u64 len, u64 offset, int flags) noexcept {
+			op_awaiter a(*this);
+			a.op_.opcode_ = code;
+			a.op_.fd_ = f.fd_;
+			a.op_.fixed_file_ = f.fixed_;
+			a.op_.buf_ = buf;
+			a.op_.len_ = u32(std::min<u64>(len, u32(-1)));
+			a.op_.offset_ = offset;
+			a.op_.flags_ = flags;
+			return a;
+		}
+
+		// ============================
+		// 提交（任意线程）
+		// ============================
+
+		inline void submit(op *o) {
+			queue_.push(std::move(o));
+			pending_.fetch_add(1, std::memory_order_seq_cst);
+			if (sleeping_.load(std::memory_order_seq_cst) && sleeping_.exchange(false, std::memory_order_acq_rel)) {
+				wake();
+			}
+		}
+
+		inline void wake() noexcept {
+			u64 one = 1;
+			[[maybe_unused]] auto r = ::write(wake_fd_, &one, sizeof(one));
+		}
+
+		inline void complete(op *o, i64 result) noexcept {
+			o->result_ = result;
+			detail::resume_waiter(&pool_, o->handle_);
+		}
+
+		// 取出本轮新提交的请求
+		template <class F>
+		inline void drain(F &&f) {
+			i64 n = 0;
+			while (std::optional<op *> o = queue_.pop()) {
+				n++;
+				f(*o);
+			}
+			if (n != 0) {
+				pending_.fetch_sub(n, std::memory_order_relaxed);
+			}
+		}
+
+		// 反应器准备阻塞；返回 false 表示有新请求，不应阻塞
+		inline bool prepare_sleep() noexcept {
+			sleeping_.store(true, std::memory_order_seq_cst);
+			if (pending_.load(std::memory_order_seq_cst) > 0 || stop_.load(std::memory_order_seq_cst)) {
+				sleeping_.store(false, std::memory_order_relaxed);
+				return false;
+			}
+			return true;
+		}
+
+		void reactor_loop() {
+			if (backend_ == io_backend::uring) {
+				uring_loop();
+			} else {
+				epoll_loop();
+			}
+		}
+
+		// ============================
+		// io_uring 后端
+		// ============================
+
+		/**
+		 * @brief 取一个 SQE；提交队列或完成队列余量不足时返回 nullptr
+		 * eventfd 读请求未挂上时，普通请求给它留一个提交槽和完成槽，
+		 * 保证反应器阻塞前 arm_wake 总能成功，提交者的唤醒不会丢失
+		 */
+		inline io_uring_sqe *reserve(bool wake_slot = false) noexcept {
+			u32 keep = (wake_slot || wake_armed_) ? 0 : 1;
+			return cqe_pending_ + keep < ring_.cq_entries() ? ring_.get_sqe(keep) : nullptr;
+		}
+
+		// 把请求写入 SQE
+		inline void prep(io_uring_sqe *sqe, op *o) noexcept {
+			sqe->fd = o->fd_;
+			sqe->flags = o->fixed_file_ ? IOSQE_FIXED_FILE : 0;
+			sqe->addr = reinterpret_cast<u64>(o->buf_);
+			sqe->len = o->len_;
+			sqe->user_data = reinterpret_cast<u64>(o);
+			switch (o->opcode_) {
+			case opcode::read:
+			case opcode::write:
+				if (o->fixed_buf_) {
+					sqe->opcode = o->opcode_ == opcode::read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+					sqe->buf_index = o->buf_index_;
+				} else {
+					sqe->opcode = o->opcode_ == opcode::read ? IORING_OP_READ : IORING_OP_WRITE;
+				}
+				sqe->off = o->offset_;
+				break;
+			case opcode::accept:
+				sqe->opcode = IORING_OP_ACCEPT;
+				sqe->addr = 0;
+				sqe->len = 0;
+				sqe->accept_flags = u32(o->flags_);
+				break;
+			case opcode::recv:
+				sqe->opcode = IORING_OP_RECV;
+				sqe->msg_flags = u32(o->flags_);
+				break;
+			case opcode::send:
+				sqe->opcode = IORING_OP_SEND;
+				sqe->msg_flags = u32(o->flags_);
+				break;
+			}
+			cqe_pending_++;
+			inflight_.push_back(o);
+		}
+
+		// 常驻一个对 eventfd 的读请求，提交者借此唤醒阻塞在 io_uring_enter 中的反应器
+		inline bool arm_wake() noexcept {
+			io_uring_sqe *sqe = reserve(true);
+			if (sqe == nullptr) {
+				return false;
+			}
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = wake_fd_;
+			sqe->addr = reinterpret_cast<u64>(&wake_buf_);
+			sqe->len = sizeof(wake_buf_);
+			sqe->off = current_pos;
+			sqe->user_data = wake_tag;
+			cqe_pending_++;
+			return true;
+		}
+
+		// 停止时取消所有在途请求
+		inline void cancel_inflight() noexcept {
+			for (op *o = inflight_.head_; o != nullptr; o = o->next_) {
+				if (o->cancel_sent_) {
+					continue;
+				}
+				io_uring_sqe *sqe = reserve(true); // 停止时不再需要唤醒请求，可以占用它的槽
+				if (sqe == nullptr) {
+					return;
+				}
+				sqe->opcode = IORING_OP_ASYNC_CANCEL;
+				sqe->fd = -1;
+				sqe->addr = reinterpret_cast<u64>(o);
+				sqe->user_data = cancel_tag;
+				cqe_pending_++;
+				o->cancel_sent_ = true;
+			}
+		}
+
+		void uring_loop() {
+			while (true) {
+				bool stopping = stop_.load(std::memory_order_acquire);
+				if (!wake_armed_ && !stopping) {
+					wake_armed_ = arm_wake();
+				}
+				// 本轮积攒的请求一次性写入提交队列
+				drain([&](op *o) { backlog_.push_back(o); });
+				while (!backlog_.empty()) {
+					op *o = backlog_.head_;
+					io_uring_sqe *sqe = stopping ? nullptr : reserve();
+					if (!stopping && sqe == nullptr) {
+						break; // 余量不足：留到完成腾出空间之后
+					}
+					backlog_.erase(o);
+					if (stopping) {
+						complete(o, -ECANCELED);
+					} else {
+						prep(sqe, o);
+					}
+				}
+				if (stopping) {
+					if (inflight_.empty()) {
+						break;
+					}
+					cancel_inflight();
+				}
+
+				// 没有挂上 eventfd 读请求时不能阻塞：阻塞期间的新提交无法唤醒反应器。
+				// 停止时不经过 prepare_sleep（它见到 stop_ 总是返回 false，会让这里空转）：
+				// 在途请求都已发出取消，总会完成；停止后的新提交由析构函数在 join 之后处理
+				u32 wait_nr = 0;
+				if (ring_.cq_empty() && (stopping || (wake_armed_ && prepare_sleep()))) {
+					wait_nr = 1;
+				}
+				int r = ring_.enter(wait_nr);
+				sleeping_.store(false, std::memory_order_relaxed);
+				if (r < 0 && r != -EINTR && r != -EBUSY && r != -EAGAIN) {
+					std::terminate(); // 环已不可用，在途请求无法完成
+				}
+				ring_.reap([&](u64 data, i32 res) {
+					cqe_pending_--;
+					if (data == wake_tag) {
+						wake_armed_ = false;
+					} else if (data != cancel_tag) {
+						op *o = reinterpret_cast<op *>(data);
+						inflight_.erase(o);
+						complete(o, res);
+					}
+				});
+			}
+		}
+
+		// ============================
+		// epoll 后端
+		// ============================
+
+		// 解析注册文件下标
+		inline int resolve(const op *o) const noexcept {
+			if (!o->fixed_file_) {
+				return o->fd_;
+			}
+			return u64(o->fd_) < files_.size() ? files_[u64(o->fd_)] : -1;
+		}
+
+		// 执行一次非阻塞的系统调用；返回结果或 -errno
+		inline i64 perform(op *o, int fd) const noexcept {
+			if (fd < 0) {
+				return -EBADF;
+			}
+			if (o->fixed_buf_ && o->buf_index_ >= buffer_count_) {
+				return -EFAULT;
+			}
+			while (true) {
+				ssize_t r = -1;
+				switch (o->opcode_) {
+				case opcode::read:
+					r = o->offset_ == current_pos ? ::read(fd, o->buf_, o->len_)
+												  : ::pread(fd, o->buf_, o->len_, off_t(o->offset_));
+					break;
+				case opcode::write:
+					r = o->offset_ == current_pos ? ::write(fd, o->buf_, o->len_)
+												  : ::pwrite(fd, o->buf_, o->len_, off_t(o->offset_));
+					break;
+				case opcode::accept:
+					r = ::accept4(fd, nullptr, nullptr, o->flags_);
+					break;
+				case opcode::recv:
+					r = ::recv(fd, o->buf_, o->len_, o->flags_ | MSG_DONTWAIT);
+					break;
+				case opcode::send:
+					r = ::send(fd, o->buf_, o->len_, o->flags_ | MSG_DONTWAIT);
+					break;
+				}
+				if (r >= 0) {
+					return r;
+				}
+				if (errno != EINTR) {
+					return errno == EWOULDBLOCK ? -EAGAIN : -errno;
+				}
+			}
+		}
+
+		inline static bool is_reader(const op *o) noexcept {
+			return o->opcode_ == opcode::read || o->opcode_ == opcode::accept || o->opcode_ == opcode::recv;
+		}
+
+		// 按两个方向的等待者重新登记一次性事件；fd 不支持 epoll（普通文件）时返回 false
+		inline bool arm(fd_state &s) noexcept {
+			epoll_event ev{};
+			ev.events = EPOLLONESHOT | (s.readers_.empty() ? 0u : u32(EPOLLIN)) | (s.writers_.empty() ? 0u : u32(EPOLLOUT));
+			ev.data.ptr = &s;
+			if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, s.fd_, &ev) == 0) {
+				return true;
+			}
+			return errno == ENOENT && ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, s.fd_, &ev) == 0;
+		}
+
+		// 新请求：同方向没有排队时先尝试一次（只对不会阻塞的 recv / send），否则排队等待就绪
+		void start(op *o) {
+			int fd = resolve(o);
+			if (fd < 0) {
+				complete(o, -EBADF);
+				return;
+			}
+			auto [it, inserted] = fds_.try_emplace(fd);
+			fd_state &s = it->second;
+			s.fd_ = fd;
+			detail::io_op_list &list = is_reader(o) ? s.readers_ : s.writers_;
+			if (list.empty() && (o->opcode_ == opcode::recv || o->opcode_ == opcode::send)) {
+				i64 r = perform(o, fd);
+				if (r != -EAGAIN) {
+					if (s.readers_.empty() && s.writers_.empty()) {
+						fds_.erase(it);
+					}
+					complete(o, r);
+					return;
+				}
+			}
+			list.push_back(o);
+			if (!arm(s)) {
+				// 普通文件总是就绪：直接同步完成
+				list.erase(o);
+				if (s.readers_.empty() && s.writers_.empty()) {
+					fds_.erase(it);
+				}
+				complete(o, perform(o, fd));
+			}
+		}
+
+		// 就绪事件：依次完成队首请求，直到遇到 EAGAIN
+		void on_ready(fd_state &s, u32 events) {
+			auto run = [&](detail::io_op_list &list) {
+				while (!list.empty()) {
+					op *o = list.head_;
+					i64 r = perform(o, s.fd_);
+					if (r == -EAGAIN) {
+						break;
+					}
+					list.erase(o);
+					complete(o, r);
+				}
+			};
+			if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+				run(s.readers_);
+			}
+			if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+				run(s.writers_);
+			}
+			if (s.readers_.empty() && s.writers_.empty()) {
+				fds_.erase(s.fd_); // 一次性事件已失效，不需要从 epoll 中删除
+				return;
+			}
+			if (!arm(s)) {
+				fail_all(s, -errno);
+			}
+		}
+
+		inline void fail_all(fd_state &s, i64 result) {
+			int fd = s.fd_;
+			for (detail::io_op_list *list : {&s.readers_, &s.writers_}) {
+				while (op *o = list->pop_front()) {
+					complete(o, result);
+				}
+			}
+			fds_.erase(fd);
+		}
+
+		void epoll_loop() {
+			constexpr int max_events = 64;
+			epoll_event events[max_events];
+			while (true) {
+				drain([&](op *o) { start(o); });
+				if (stop_.load(std::memory_order_acquire)) {
+					while (!fds_.empty()) {
+						fail_all(fds_.begin()->second, -ECANCELED);
+					}
+					break;
+				}
+				int timeout = prepare_sleep() ? -1 : 0;
+				int n = ::epoll_wait(epoll_fd_, events, max_events, timeout);
+				sleeping_.store(false, std::memory_order_relaxed);
+				for (int i = 0; i < n; ++i) {
+					if (events[i].data.ptr == nullptr) {
+						u64 v;
+						[[maybe_unused]] auto r = ::read(wake_fd_, &v, sizeof(v));
+						continue;
+					}
+					on_ready(*static_cast<fd_state *>(events[i].data.ptr), events[i].events);
+				}
+			}
+		}
+
+	private:
+		thread_pool &pool_;
+		io_backend backend_ = io_backend::epoll;
+
+		// 提交侧（任意线程）
+		atomic_queue<op *, queue_layout::compact> queue_{1024};
+		CHENC_CACHE_ALIGN std::atomic<i64> pending_{0}; // 已入队、反应器尚未取走的请求数
+		CHENC_CACHE_ALIGN std::atomic<bool> sleeping_{false};
+		std::atomic<bool> stop_{false};
+		int wake_fd_ = -1;
+
+		// 反应器线程私有
+		CHENC_CACHE_ALIGN detail::uring ring_;
+		u32 cqe_pending_ = 0;		// 已提交、尚未收到 CQE 的 SQE 数
+		bool wake_armed_ = false;	// eventfd 读请求在途
+		detail::io_op_list inflight_; // 已提交到内核的请求
+		detail::io_op_list backlog_;  // 因队列余量不足推迟到下一轮的请求
+		u64 wake_buf_ = 0;
+		int epoll_fd_ = -1;
+		std::unordered_map<int, fd_state> fds_;
+
+		// 注册资源
+		std::vector<int> files_;
+		u64 buffer_count_ = 0;
+
+		std::thread reactor_;
+	};
+} // namespace chenc::thread
+#endif
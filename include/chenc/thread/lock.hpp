@@ -1,14 +1,28 @@
 #pragma once
 
+#include "chenc/core/cpp.hpp"
 #include "chenc/core/cpu/relax.hpp"
+#include "chenc/core/cpu/time.hpp"
+#include "chenc/core/cpu/topology.hpp"
 #include "chenc/core/type.hpp"
+#include "chenc/thread/futex.hpp"
+#include "chenc/thread/lock_profiler.hpp"
+#include "chenc/thread/thread_id.hpp"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <bit>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <semaphore>
 #include <stdexcept>
 #include <thread>
+#include <type_traits>
 
 namespace chenc::lock {
 	inline static constexpr u64 wait_thread_capacity = 0x3FFF'FFFF;
@@ -18,265 +32,1635 @@ namespace chenc::lock {
 		u32 wait_threshold_ns_ = 20000; // 等待时间超过此值则强制尝试挂起
 		u8 fast_test_size_ = 2;			// 快速路径的重试次数
 		u32 start_sleep_ns_ = 100;		// 初始睡眠时间
+
+		/**
+		 * 自适应模式：忽略上面三个固定阈值，按 spin_profile 中的滑动估计决定自旋多久，
+		 * 估计之外仍未拿到锁则直接挂起
+		 */
+		bool adaptive_ = false;
+		u32 adaptive_max_spins_ = 512; // 自旋上限（cpu::relax 次数）
+
+		// 竞争统计：记录到 lock_profiler，可用 set_label 命名；关闭时没有任何开销
+		bool profile_ = false;
+	};
+	inline static constexpr perf_config adaptive_config{.adaptive_ = true};
+	inline static constexpr perf_config profile_config{.profile_ = true};
+
+	/**
+	 * @brief 自适应自旋的统计（glibc PTHREAD_MUTEX_ADAPTIVE_NP 风格）
+	 * spins_ 是最近几次靠自旋拿到锁所需 relax 次数的滑动平均（1/8 权重），近似反映持有时间；
+	 * 本次允许自旋 2 * spins_ + min_spins 次。自旋失败而挂起时估计衰减 1/4，
+	 * 持有时间长的锁很快退化为几乎不自旋，短临界区的锁则保持足够的自旋来避免挂起。
+	 * 每个自适应锁内嵌一份；也可以按调用点定义一份 static 对象传给 lock(profile)。
+	 * 统计只用 relaxed 读写，并发更新丢失个别样本无关紧要。
+	 */
+	struct spin_profile {
+		inline static constexpr u32 min_spins = 16;
+
+		std::atomic<u32> spins_{min_spins};
+
+		inline u32 limit(u32 max_spins) const noexcept {
+			u32 est = spins_.load(std::memory_order_relaxed);
+			return std::min<u32>(max_spins, est * 2 + min_spins);
+		}
+
+		// 自旋 count 次后拿到锁
+		inline void on_spin_success(u32 count) noexcept {
+			i64 est = spins_.load(std::memory_order_relaxed);
+			spins_.store(u32(est + (i64(count) - est) / 8), std::memory_order_relaxed);
+		}
+
+		// 自旋到上限仍未拿到锁，已挂起
+		inline void on_park() noexcept {
+			u32 est = spins_.load(std::memory_order_relaxed);
+			spins_.store(est - est / 4, std::memory_order_relaxed);
+		}
 	};
 
+	namespace detail {
+		/**
+		 * @brief 竞争路径的计时与指数回避
+		 * 用 cpu::cycle_clock 的 tick 计时，阈值在构造时换算一次；
+		 * 自旋时每 relax_burst 次 cpu::relax() 才读一次时钟，而不是每次都调用 steady_clock::now()
+		 */
+		template <perf_config config>
+		class backoff {
+		public:
+			inline static constexpr u32 relax_burst = 8;
+
+			backoff() noexcept
+				: clock_(cpu::cycle_clock::get()),
+				  start_(clock_.now()),
+				  threshold_(i64(clock_.from_ns(config.wait_threshold_ns_))),
+				  dur_(i64(clock_.from_ns(config.start_sleep_ns_))) {}
+
+			inline i64 elapsed() const noexcept { return i64(clock_.now() - start_); }
+
+			// 已超过当前回避时长（快速尝试阶段使用）
+			inline bool past_dur() const noexcept { return elapsed() > dur_; }
+
+			// 仍处于自旋阶段
+			inline bool spinning() const noexcept { return elapsed() < threshold_; }
+
+			// 指数回避：自旋到 wait_threshold - dur 为止
+			inline void spin() const noexcept {
+				const i64 target = threshold_ - dur_;
+				while (elapsed() < target) {
+					for (u32 i = 0; i < relax_burst; i++) {
+						cpu::relax();
+					}
+				}
+			}
+
+			inline void next() noexcept { dur_ *= 2; }
+
+		private:
+			const cpu::cycle_clock &clock_;
+			const u64 start_;
+			const i64 threshold_;
+			i64 dur_;
+		};
+
+		// 32 位锁字走 thread::futex_*（支持超时等待），其余宽度走 std::atomic::wait / notify
+		template <typename Word>
+		CHENC_FORCE_INLINE void wait_on(std::atomic<Word> &word, Word v) noexcept {
+			if constexpr (std::is_same_v<Word, u32>) {
+				thread::futex_wait(word, v);
+			} else {
+				word.wait(v, std::memory_order_relaxed);
+			}
+		}
+
+		template <typename Word>
+		CHENC_FORCE_INLINE void wake_one(std::atomic<Word> &word) noexcept {
+			if constexpr (std::is_same_v<Word, u32>) {
+				thread::futex_wake_one(word);
+			} else {
+				word.notify_one();
+			}
+		}
+
+		/**
+		 * @brief 独占锁的竞争路径：先按 config 指数回避自旋，超过 wait_threshold_ns_ 后在 word 上挂起
+		 * @param try_acquire 尝试获取，成功返回 true
+		 * @param locked 判断 word 的值是否仍处于占用状态
+		 * 挂起期间 wait_count 非零，解锁方据此决定是否 notify；获取成功后才减回
+		 * @return 是否挂起过
+		 */
+		template <perf_config config, typename Word, typename TryAcquire, typename Locked>
+		CHENC_NO_INLINE bool lock_slow(std::atomic<Word> &word, std::atomic<u32> &wait_count,
+									   TryAcquire try_acquire, Locked locked) noexcept {
+			backoff<config> bo;
+			bool is_add_wait = false;
+			bool skip_spin = false;
+			// 1. 快速尝试
+			for (u64 i = 1; i < config.fast_test_size_; i++) {
+				if (try_acquire()) [[likely]] {
+					return false;
+				}
+				if (bo.past_dur()) {
+					skip_spin = true;
+					break;
+				}
+			}
+			// 2. 慢速尝试
+			while (!try_acquire()) {
+				if (!skip_spin && bo.spinning()) [[likely]] {
+					// 1. 指数回避
+					bo.spin();
+				} else {
+					// 2. 系统等待
+					if (is_add_wait == false) [[likely]] {
+						wait_count.fetch_add(1, std::memory_order_seq_cst);
+						is_add_wait = true;
+					}
+					Word v = word.load(std::memory_order_seq_cst);
+					if (locked(v)) {
+						wait_on(word, v);
+					}
+					skip_spin = false;
+				}
+				bo.next();
+			}
+			if (is_add_wait) {
+				wait_count.fetch_sub(1, std::memory_order_relaxed);
+			}
+			return is_add_wait;
+		}
+
+		/**
+		 * @brief 自适应竞争路径：只读自旋 profile.limit() 次，期间看到锁空闲才尝试获取；
+		 * 超过估计后直接在 word 上挂起，并把结果反馈给 profile
+		 * @return 是否挂起过
+		 */
+		template <perf_config config, typename Word, typename TryAcquire, typename Locked>
+		CHENC_NO_INLINE bool lock_adaptive(std::atomic<Word> &word, std::atomic<u32> &wait_count, spin_profile &profile,
+										   TryAcquire try_acquire, Locked locked) noexcept {
+			u32 limit = profile.limit(config.adaptive_max_spins_);
+			for (u32 count = 0; count < limit; count++) {
+				cpu::relax();
+				if (!locked(word.load(std::memory_order_relaxed)) && try_acquire()) {
+					profile.on_spin_success(count + 1);
+					return false;
+				}
+			}
+			profile.on_park();
+			wait_count.fetch_add(1, std::memory_order_seq_cst);
+			while (!try_acquire()) {
+				Word v = word.load(std::memory_order_seq_cst);
+				if (locked(v)) {
+					wait_on(word, v);
+				}
+			}
+			wait_count.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		/**
+		 * @brief 带截止时间的独占竞争路径：与 lock_slow 相同的自旋 / 挂起，挂起为 futex 绝对超时等待
+		 * 到期后先减回 wait_count，再做最后一次尝试：成功则照常返回；失败说明锁此刻被他人持有，
+		 * 它解锁时会按 wait_count 唤醒剩余的等待者，即使解锁方发给本线程的唤醒被超时吞掉也不会丢失
+		 * @param parked 输出是否挂起过
+		 * @return 是否获取成功
+		 */
+		template <perf_config config, typename TryAcquire, typename Locked>
+		CHENC_NO_INLINE bool lock_slow_until(std::atomic<u32> &word, std::atomic<u32> &wait_count,
+											 thread::futex_clock::time_point deadline, bool &parked,
+											 TryAcquire try_acquire, Locked locked) noexcept {
+			backoff<config> bo;
+			while (!try_acquire()) {
+				if (thread::futex_clock::now() >= deadline) {
+					if (parked) {
+						wait_count.fetch_sub(1, std::memory_order_seq_cst);
+					}
+					return try_acquire();
+				}
+				if (!parked && bo.spinning()) [[likely]] {
+					bo.spin();
+					bo.next();
+				} else {
+					if (!parked) {
+						wait_count.fetch_add(1, std::memory_order_seq_cst);
+						parked = true;
+					}
+					u32 v = word.load(std::memory_order_seq_cst);
+					if (locked(v)) {
+						thread::futex_wait_until(word, v, deadline);
+					}
+				}
+			}
+			if (parked) {
+				wait_count.fetch_sub(1, std::memory_order_relaxed);
+			}
+			return true;
+		}
+
+		// 非自适应配置不占空间
+		struct no_profile {};
+		template <perf_config config>
+		using profile_storage = std::conditional_t<config.adaptive_, spin_profile, no_profile>;
+	} // namespace detail
+
 	// 独占锁
 	template <perf_config config = perf_config{}>
 	class alignas(8) mutex {
 	public:
 		[[nodiscard]] inline bool try_lock() noexcept {
-			bool expected = false;
-			return flag_.compare_exchange_strong(expected, true,
+			if (try_acquire()) {
+				site_.acquired(this);
+				return true;
+			}
+			return false;
+		}
+		inline void lock() noexcept {
+			// 快速尝试
+			if (try_acquire()) [[likely]] {
+				site_.acquired(this);
+				return;
+			}
+			if constexpr (config.adaptive_) {
+				lock_contended(profile_);
+			} else {
+				u64 start = site_.wait_start();
+				bool parked = detail::lock_slow<config>(
+					flag_, wait_count_,
+					[this]() noexcept { return try_acquire(); },
+					[](u32 v) noexcept { return v != 0; });
+				site_.acquired_contended(this, start, parked);
+			}
+		}
+
+		/**
+		 * @brief 限时加锁：超时返回 false
+		 * 挂起使用 FUTEX_WAIT_BITSET 绝对超时；超时放弃时等待计数已减回
+		 */
+		template <typename Rep, typename Period>
+		[[nodiscard]] inline bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+			return try_lock_until_steady(thread::futex_deadline_after(timeout));
+		}
+
+		template <typename Clock, typename Duration>
+		[[nodiscard]] inline bool try_lock_until(const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+			return try_lock_until_steady(thread::to_futex_deadline(deadline));
+		}
+
+		/**
+		 * @brief 使用调用点自己的统计加锁（按自适应路径竞争）
+		 * 同一把锁在不同调用点临界区长短差异很大时，用 static spin_profile 分别统计
+		 */
+		inline void lock(spin_profile &profile) noexcept {
+			if (try_acquire()) [[likely]] {
+				site_.acquired(this);
+				return;
+			}
+			lock_contended(profile);
+		}
+
+		inline void unlock() noexcept {
+			site_.released(this);
+			// seq_cst：与等待方的 wait_count_ 登记构成 Dekker 对，避免丢失唤醒
+			flag_.store(0, std::memory_order_seq_cst);
+
+			// 如果有等待者，发出通知
+			if (wait_count_.load(std::memory_order_seq_cst) > 0) [[unlikely]] {
+				thread::futex_wake_one(flag_);
+			}
+		}
+
+		// 统计标签（perf_config::profile_ 打开时可用），应在锁被共享前设置
+		inline void set_label(const char *label) noexcept
+			requires(config.profile_)
+		{
+			site_.label_.store(label, std::memory_order_relaxed);
+		}
+
+	private:
+		[[nodiscard]] inline bool try_acquire() noexcept {
+			u32 expected = 0;
+			return flag_.compare_exchange_strong(expected, 1,
 												 std::memory_order_acquire,
 												 std::memory_order_relaxed);
 		}
+
+		inline void lock_contended(spin_profile &profile) noexcept {
+			u64 start = site_.wait_start();
+			bool parked = detail::lock_adaptive<config>(
+				flag_, wait_count_, profile,
+				[this]() noexcept { return try_acquire(); },
+				[](u32 v) noexcept { return v != 0; });
+			site_.acquired_contended(this, start, parked);
+		}
+
+		inline bool try_lock_until_steady(thread::futex_clock::time_point deadline) noexcept {
+			if (try_acquire()) [[likely]] {
+				site_.acquired(this);
+				return true;
+			}
+			u64 start = site_.wait_start();
+			bool parked = false;
+			if (!detail::lock_slow_until<config>(
+					flag_, wait_count_, deadline, parked,
+					[this]() noexcept { return try_acquire(); },
+					[](u32 v) noexcept { return v != 0; })) {
+				return false;
+			}
+			site_.acquired_contended(this, start, parked);
+			return true;
+		}
+
+		std::atomic<u32> flag_ = 0; // 0 空闲，1 已加锁；futex 等待字
+		std::atomic<u32> wait_count_ = 0;
+		[[no_unique_address]] detail::profile_storage<config> profile_;
+		[[no_unique_address]] detail::lock_site<config.profile_> site_;
+	};
+	inline static constexpr u64 mutex_size = sizeof(mutex<>);
+
+	/**
+	 * @brief 三态 futex 独占锁（Drepper, "Futexes Are Tricky"）
+	 * state_: 0 空闲 | 1 已加锁 | 2 已加锁且可能有等待者
+	 * - 不需要单独的等待计数：等待者挂起前把状态置为 2，解锁方 exchange(0) 看到 2 才发 FUTEX_WAKE_PRIVATE，
+	 *   无竞争解锁为一次 exchange，有竞争解锁恰好一次系统调用
+	 * - 被唤醒者用 exchange(2) 获取，保守地保留"可能有等待者"，最多多一次无人可唤醒的系统调用
+	 * - 挂起前的自旋沿用 perf_config（普通为 wait_threshold_ns_，自适应按 spin_profile）
+	 * - 超时放弃时没有计数需要回滚，状态停留在 2 只会让下次解锁多一次唤醒
+	 */
+	template <perf_config config = perf_config{}>
+	class alignas(4) futex_mutex {
+	private:
+		inline static constexpr u32 unlocked = 0;
+		inline static constexpr u32 locked = 1;
+		inline static constexpr u32 contended = 2;
+
+	public:
+		[[nodiscard]] inline bool try_lock() noexcept {
+			u32 expected = unlocked;
+			if (state_.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed)) {
+				site_.acquired(this);
+				return true;
+			}
+			return false;
+		}
+
+		inline void lock() noexcept {
+			u32 c = unlocked;
+			if (state_.compare_exchange_strong(c, locked, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]] {
+				site_.acquired(this);
+				return;
+			}
+			u64 start = site_.wait_start();
+			bool parked = lock_contended<false>(c, {});
+			site_.acquired_contended(this, start, parked);
+		}
+
+		template <typename Rep, typename Period>
+		[[nodiscard]] inline bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+			return try_lock_until_steady(thread::futex_deadline_after(timeout));
+		}
+
+		template <typename Clock, typename Duration>
+		[[nodiscard]] inline bool try_lock_until(const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+			return try_lock_until_steady(thread::to_futex_deadline(deadline));
+		}
+
+		inline void unlock() noexcept {
+			site_.released(this);
+			if (state_.exchange(unlocked, std::memory_order_release) == contended) [[unlikely]] {
+				thread::futex_wake_one(state_);
+			}
+		}
+
+		// 统计标签（perf_config::profile_ 打开时可用），应在锁被共享前设置
+		inline void set_label(const char *label) noexcept
+			requires(config.profile_)
+		{
+			site_.label_.store(label, std::memory_order_relaxed);
+		}
+
+	private:
+		// 自旋阶段：只读等待锁空闲再 CAS，不把状态改成 2
+		inline bool spin_acquire(u32 &c) noexcept {
+			auto try_acquire = [&]() noexcept {
+				c = state_.load(std::memory_order_relaxed);
+				return c == unlocked &&
+					   state_.compare_exchange_strong(c, locked, std::memory_order_acquire, std::memory_order_relaxed);
+			};
+			if constexpr (config.adaptive_) {
+				u32 limit = profile_.limit(config.adaptive_max_spins_);
+				for (u32 count = 0; count < limit; count++) {
+					cpu::relax();
+					if (try_acquire()) {
+						profile_.on_spin_success(count + 1);
+						return true;
+					}
+				}
+				profile_.on_park();
+			} else {
+				detail::backoff<config> bo;
+				while (bo.spinning()) {
+					for (u32 i = 0; i < detail::backoff<config>::relax_burst; i++) {
+						cpu::relax();
+					}
+					if (try_acquire()) {
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * @brief 竞争路径
+		 * @return 不限时：是否挂起过；限时：是否获取成功
+		 */
+		template <bool timed>
+		CHENC_NO_INLINE bool lock_contended(u32 c, thread::futex_clock::time_point deadline) noexcept {
+			if (spin_acquire(c)) {
+				return !timed ? false : true;
+			}
+			if (c != contended) {
+				c = state_.exchange(contended, std::memory_order_acquire);
+			}
+			bool parked = false;
+			while (c != unlocked) {
+				if constexpr (timed) {
+					if (!thread::futex_wait_until(state_, contended, deadline)) {
+						return false;
+					}
+				} else {
+					thread::futex_wait(state_, contended);
+				}
+				parked = true;
+				c = state_.exchange(contended, std::memory_order_acquire);
+			}
+			return timed ? true : parked;
+		}
+
+		inline bool try_lock_until_steady(thread::futex_clock::time_point deadline) noexcept {
+			u32 c = unlocked;
+			if (state_.compare_exchange_strong(c, locked, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]] {
+				site_.acquired(this);
+				return true;
+			}
+			u64 start = site_.wait_start();
+			if (!lock_contended<true>(c, deadline)) {
+				return false;
+			}
+			site_.acquired_contended(this, start, true);
+			return true;
+		}
+
+		std::atomic<u32> state_{unlocked};
+		[[no_unique_address]] detail::profile_storage<config> profile_;
+		[[no_unique_address]] detail::lock_site<config.profile_> site_;
+	};
+	inline static constexpr u64 futex_mutex_size = sizeof(futex_mutex<>);
+
+#if defined(__linux__)
+	/**
+	 * @brief 优先级继承独占锁（FUTEX_LOCK_PI）
+	 * state_ 存放持有者 TID：无竞争加锁 / 解锁各一次 CAS，不进内核；
+	 * 竞争时由内核排队并临时提升持有者优先级，避免实时线程被低优先级持有者阻塞（优先级反转）。
+	 * 只能由加锁线程解锁；没有自旋阶段，适合混合优先级线程共用的锁。
+	 */
+	class alignas(4) pi_mutex {
+	public:
+		[[nodiscard]] inline bool try_lock() noexcept {
+			u32 expected = 0;
+			return state_.compare_exchange_strong(expected, thread::this_tid(), std::memory_order_acquire,
+												  std::memory_order_relaxed);
+		}
+
 		inline void lock() noexcept {
-			// 0. 快速尝试
 			if (try_lock()) [[likely]] {
 				return;
-			} else {
-				auto t1 = std::chrono::steady_clock::now();
-				auto dur = std::chrono::nanoseconds(config.start_sleep_ns_);
-				bool is_add_wait = false;
-				// 1. 快速尝试
-				for (u64 i = 1; i < config.fast_test_size_; i++) {
-					if (try_lock()) [[likely]] {
+			}
+			lock_slow();
+		}
+
+		inline void unlock() noexcept {
+			u32 expected = thread::this_tid();
+			// 竞争时内核置了 FUTEX_WAITERS 位，CAS 失败，由内核交接
+			if (!state_.compare_exchange_strong(expected, 0, std::memory_order_release, std::memory_order_relaxed)) [[unlikely]] {
+				thread::futex_unlock_pi(state_);
+			}
+		}
+
+	private:
+		CHENC_NO_INLINE void lock_slow() noexcept {
+			// 只有 EINTR / EAGAIN（持有者正在退出）可以重试；
+			// EDEADLK（重复加锁）、ENOSYS、EINVAL（state_ 被破坏）等重试也不会成功，直接终止
+			for (;;) {
+				int err = thread::futex_lock_pi(state_);
+				if (err == 0) {
+					return;
+				}
+				if (err != EINTR && err != EAGAIN) [[unlikely]] {
+					std::terminate();
+				}
+				if (try_lock()) {
+					return;
+				}
+			}
+		}
+
+		std::atomic<u32> state_{0};
+	};
+#endif
+
+	/**
+	 * @brief 递归锁
+	 * state_ 布局: [32-63位]: 持有者 thread::this_id() + 1 | [0-31位]: 重入深度；0 表示未加锁
+	 * - 重入只有持有者自己会走到：一次 relaxed 读加一次普通写，没有原子 RMW
+	 * - 首次获取是一次 CAS，竞争时复用 mutex<> 的自旋 / 挂起路径
+	 * 重入深度上限为 2^32 - 1
+	 */
+	template <perf_config config = perf_config{}>
+	class alignas(8) recursive_mutex {
+	private:
+		inline static constexpr u64 depth_mask = 0xFFFF'FFFF;
+		inline static constexpr u64 owner_mask = ~depth_mask;
+
+		// 当前线程的持有者标记（高 32 位）
+		inline static u64 self_tag() noexcept {
+			return u64(u32(thread::this_id()) + 1) << 32;
+		}
+
+	public:
+		[[nodiscard]] inline bool try_lock() noexcept {
+			u64 self = self_tag();
+			u64 state = state_.load(std::memory_order_relaxed);
+			if ((state & owner_mask) == self) {
+				state_.store(state + 1, std::memory_order_relaxed);
+				return true;
+			}
+			u64 expected = 0;
+			return state_.compare_exchange_strong(expected, self | 1,
+												  std::memory_order_acquire,
+												  std::memory_order_relaxed);
+		}
+
+		inline void lock() noexcept {
+			u64 self = self_tag();
+			u64 state = state_.load(std::memory_order_relaxed);
+			// 重入
+			if ((state & owner_mask) == self) [[likely]] {
+				state_.store(state + 1, std::memory_order_relaxed);
+				return;
+			}
+			// 快速尝试
+			u64 expected = 0;
+			if (state_.compare_exchange_strong(expected, self | 1,
+											   std::memory_order_acquire,
+											   std::memory_order_relaxed)) [[likely]] {
+				return;
+			}
+			auto try_acquire = [this, self]() noexcept {
+				u64 expected = 0;
+				return state_.compare_exchange_strong(expected, self | 1,
+													  std::memory_order_acquire,
+													  std::memory_order_relaxed);
+			};
+			auto locked = [](u64 v) noexcept { return v != 0; };
+			if constexpr (config.adaptive_) {
+				detail::lock_adaptive<config>(state_, wait_count_, profile_, try_acquire, locked);
+			} else {
+				detail::lock_slow<config>(state_, wait_count_, try_acquire, locked);
+			}
+		}
+
+		inline void unlock() noexcept {
+			u64 state = state_.load(std::memory_order_relaxed);
+			// 退出一层重入
+			if ((state & depth_mask) > 1) [[likely]] {
+				state_.store(state - 1, std::memory_order_relaxed);
+				return;
+			}
+			state_.store(0, std::memory_order_seq_cst);
+			if (wait_count_.load(std::memory_order_seq_cst) > 0) [[unlikely]] {
+				state_.notify_one();
+			}
+		}
+
+		// 当前线程是否持有该锁
+		[[nodiscard]] inline bool owned() const noexcept {
+			return (state_.load(std::memory_order_relaxed) & owner_mask) == self_tag();
+		}
+
+	private:
+		std::atomic<u64> state_ = 0;
+		std::atomic<u32> wait_count_ = 0;
+		[[no_unique_address]] detail::profile_storage<config> profile_;
+	};
+	inline static constexpr u64 recursive_mutex_size = sizeof(recursive_mutex<>);
+
+	namespace detail {
+		// queue_mutex 的排队节点；等待者只在自己的节点上自旋
+		struct CHENC_CACHE_ALIGN queue_node {
+			inline static constexpr u32 granted = 0;
+			inline static constexpr u32 waiting = 1;
+			inline static constexpr u32 parked = 2;
+
+			std::atomic<queue_node *> next_{nullptr};
+			std::atomic<u32> state_{granted};
+			queue_node *free_next_ = nullptr;
+		};
+
+		/**
+		 * @brief 每线程的 queue_node 空闲链表
+		 * 一个线程可能同时持有多把 queue_mutex，所以按次取用节点而不是每线程固定一个；
+		 * 解锁后节点不再被任何人引用，归还到解锁线程的链表。
+		 * 节点在进程生命周期内从不释放：线程退出时整条链表转入全局链表，供其他线程取用，
+		 * 交接方在 exchange 之后对节点的访问因此总是落在有效内存上。
+		 */
+		class queue_node_pool {
+		private:
+			struct thread_cache {
+				queue_node *head_ = nullptr;
+				bool alive_ = true;
+
+				~thread_cache() {
+					alive_ = false;
+					if (head_ != nullptr) {
+						queue_node *tail = head_;
+						while (tail->free_next_ != nullptr) {
+							tail = tail->free_next_;
+						}
+						orphans().push(head_, tail);
+						head_ = nullptr;
+					}
+				}
+			};
+
+			// 已退出线程留下的节点
+			struct orphan_list {
+				std::mutex mutex_;
+				queue_node *head_ = nullptr;
+
+				inline void push(queue_node *first, queue_node *last) noexcept {
+					std::lock_guard guard(mutex_);
+					last->free_next_ = head_;
+					head_ = first;
+				}
+
+				inline queue_node *pop() noexcept {
+					std::lock_guard guard(mutex_);
+					queue_node *n = head_;
+					if (n != nullptr) {
+						head_ = n->free_next_;
+					}
+					return n;
+				}
+			};
+
+			inline static thread_cache &local() noexcept {
+				static thread_local thread_cache cache;
+				return cache;
+			}
+
+			// 有意不析构：静态析构之后退出的线程仍可能归还节点
+			inline static orphan_list &orphans() noexcept {
+				static orphan_list *list = new orphan_list;
+				return *list;
+			}
+
+		public:
+			inline static queue_node *acquire() noexcept {
+				thread_cache &tc = local();
+				if (queue_node *n = tc.head_; n != nullptr) [[likely]] {
+					tc.head_ = n->free_next_;
+					return n;
+				}
+				if (queue_node *n = orphans().pop(); n != nullptr) {
+					return n;
+				}
+				return new queue_node;
+			}
+
+			inline static void release(queue_node *n) noexcept {
+				thread_cache &tc = local();
+				if (!tc.alive_) [[unlikely]] {
+					orphans().push(n, n);
+					return;
+				}
+				n->free_next_ = tc.head_;
+				tc.head_ = n;
+			}
+		};
+	} // namespace detail
+
+	/**
+	 * @brief MCS 排队锁
+	 * - 加锁者把自己的节点 exchange 到 tail_，挂在前驱之后，只在自己节点的 state_ 上自旋，
+	 *   不会所有等待者抢同一个标志；解锁把锁直接交给队首后继，严格 FIFO
+	 * - 自旋预算沿用 perf_config：普通配置自旋 wait_threshold_ns_，自适应配置按 spin_profile 估计；
+	 *   预算用完后把节点标记为 parked 并在其上挂起，交接方只在看到 parked 时才 notify
+	 * - 无竞争时加锁一次 exchange，解锁一次 CAS，与 mutex<> 相当
+	 * 适合竞争激烈、需要公平交接的临界区；竞争很少时 mutex<> 更省（不需要取节点）。不可重入。
+	 * 线程数超过核数时，FIFO 交接会把锁交给尚未被调度的等待者，此时宜用自适应配置缩短自旋。
+	 */
+	template <perf_config config = perf_config{}>
+	class queue_mutex {
+	private:
+		using node = detail::queue_node;
+		using pool = detail::queue_node_pool;
+
+	public:
+		queue_mutex() noexcept = default;
+		queue_mutex(const queue_mutex &) = delete;
+		queue_mutex &operator=(const queue_mutex &) = delete;
+
+		[[nodiscard]] inline bool try_lock() noexcept {
+			if (tail_.load(std::memory_order_relaxed) != nullptr) {
+				return false;
+			}
+			node *n = pool::acquire();
+			n->next_.store(nullptr, std::memory_order_relaxed);
+			node *expected = nullptr;
+			if (tail_.compare_exchange_strong(expected, n, std::memory_order_acquire, std::memory_order_relaxed)) {
+				holder_ = n;
+				return true;
+			}
+			pool::release(n);
+			return false;
+		}
+
+		inline void lock() noexcept {
+			node *n = pool::acquire();
+			n->next_.store(nullptr, std::memory_order_relaxed);
+			n->state_.store(node::waiting, std::memory_order_relaxed);
+			node *pred = tail_.exchange(n, std::memory_order_acq_rel);
+			if (pred != nullptr) [[unlikely]] {
+				pred->next_.store(n, std::memory_order_release);
+				wait_turn(*n);
+			}
+			holder_ = n;
+		}
+
+		inline void unlock() noexcept {
+			node *n = holder_;
+			node *next = n->next_.load(std::memory_order_acquire);
+			if (next == nullptr) {
+				node *expected = n;
+				if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release,
+												  std::memory_order_relaxed)) [[likely]] {
+					pool::release(n);
+					return;
+				}
+				// 后继已 exchange 到 tail_，但还没挂到我们的节点上
+				next = wait_successor(*n);
+			}
+			grant(*next);
+			pool::release(n);
+		}
+
+	private:
+		CHENC_NO_INLINE void wait_turn(node &n) noexcept {
+			if constexpr (config.adaptive_) {
+				u32 limit = profile_.limit(config.adaptive_max_spins_);
+				for (u32 count = 0; count < limit; count++) {
+					cpu::relax();
+					if (n.state_.load(std::memory_order_acquire) == node::granted) {
+						profile_.on_spin_success(count + 1);
+						return;
+					}
+				}
+				profile_.on_park();
+			} else {
+				detail::backoff<config> bo;
+				while (bo.spinning()) {
+					for (u32 i = 0; i < detail::backoff<config>::relax_burst; i++) {
+						cpu::relax();
+					}
+					if (n.state_.load(std::memory_order_acquire) == node::granted) {
+						return;
+					}
+				}
+			}
+			// CAS 失败说明已经被授予
+			u32 expected = node::waiting;
+			if (n.state_.compare_exchange_strong(expected, node::parked, std::memory_order_acquire,
+												 std::memory_order_acquire)) {
+				while (n.state_.load(std::memory_order_acquire) != node::granted) {
+					thread::futex_wait(n.state_, node::parked);
+				}
+			}
+		}
+
+		CHENC_NO_INLINE static node *wait_successor(node &n) noexcept {
+			node *next;
+			for (u32 count = 0; (next = n.next_.load(std::memory_order_acquire)) == nullptr; count++) {
+				if (count < config.adaptive_max_spins_) {
+					cpu::relax();
+				} else {
+					// 后继在 exchange 与链接之间被换出
+					std::this_thread::yield();
+				}
+			}
+			return next;
+		}
+
+		/**
+		 * 交接：exchange 之后被授予者可能已经醒来、解锁并归还节点，甚至线程已经退出；
+		 * 节点由 queue_node_pool 保证不被释放，再被他人取用时这次唤醒只是一次虚假唤醒
+		 */
+		inline static void grant(node &n) noexcept {
+			if (n.state_.exchange(node::granted, std::memory_order_release) == node::parked) [[unlikely]] {
+				thread::futex_wake_one(n.state_);
+			}
+		}
+
+		std::atomic<node *> tail_{nullptr};
+		node *holder_ = nullptr; // 只由持有者读写，随锁的交接同步
+		[[no_unique_address]] detail::profile_storage<config> profile_;
+	};
+	inline static constexpr u64 queue_mutex_size = sizeof(queue_mutex<>);
+
+	// 读写锁
+	template <perf_config config = perf_config{}>
+	class shared_mutex {
+	private:
+		inline static constexpr i32 write_locked_bit = 1 << 31;
+		inline static constexpr i32 write_pending_bit = 1 << 30;
+		inline static constexpr i32 upgrade_bit = 1 << 29;
+		inline static constexpr i32 upgrading_bit = 1 << 28;
+		inline static constexpr i32 reader_mask = 0x0FFFFFFF;
+
+		/**
+		 * lock_state_ 布局:
+		 * [31位]: 写锁位 | [30位]: 写者挂起位 | [29位]: 可升级读锁位 | [28位]: 升级中位 | [0-27位]: 读者计数（含升级者）
+		 * 升级中位只由 upgrade_to_unique 置位、在转为写锁时清除，与写者挂起位分开：
+		 * 超时放弃的写者清除挂起位时不会把正在等待读者离开的升级者一起放掉
+		 */
+		std::atomic<i32> lock_state_{0};
+
+		// 唤醒版本号：使用独立缓存行防止伪共享
+		std::atomic<u32> write_signal_{0};
+		std::atomic<u32> read_signal_{0};
+		std::atomic<u32> upgrade_signal_{0}; // 升级者等待其他读者离开
+
+		// 等待线程计数
+		std::atomic<u16> write_wait_count_{0};
+		std::atomic<u16> read_wait_count_{0};
+
+	public:
+		// ================== 写锁 (Exclusive Lock) ==================
+
+		[[nodiscard]] inline bool try_lock() noexcept {
+			if (try_acquire()) {
+				site_.acquired(this);
+				return true;
+			}
+			return false;
+		}
+
+		inline void lock() noexcept {
+			if (try_acquire()) [[likely]] {
+				site_.acquired(this);
+				return;
+			}
+			u64 start = site_.wait_start();
+			bool parked = false;
+			lock_writer<false>({}, parked);
+			site_.acquired_contended(this, start, parked);
+		}
+
+		/**
+		 * @brief 限时加写锁：超时返回 false
+		 * 放弃时等待计数已减回；若已没有登记的写者，清掉写者挂起位并唤醒被它挡住的读者
+		 */
+		template <typename Rep, typename Period>
+		[[nodiscard]] inline bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+			return try_lock_until_steady(thread::futex_deadline_after(timeout));
+		}
+
+		template <typename Clock, typename Duration>
+		[[nodiscard]] inline bool try_lock_until(const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+			return try_lock_until_steady(thread::to_futex_deadline(deadline));
+		}
+
+		/**
+		 * @brief 统一解锁函数
+		 */
+		inline void unlock() noexcept {
+			site_.released(this);
+			i32 state = lock_state_.load(std::memory_order_relaxed);
+
+			if (state & write_locked_bit) {
+				// --- 释放写锁逻辑 ---
+				bool has_writer = (write_wait_count_.load(std::memory_order_relaxed) > 0);
+
+				// 1. 释放锁。如果有写者在等，保留 pending 位
+				lock_state_.store(has_writer ? write_pending_bit : 0, std::memory_order_seq_cst);
+
+				// 2. 关键：全内存屏障。确保上面的 store 对所有 CPU 可见后，再读取 wait_count
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				// 重新读取：上面的 has_writer 可能早于某个写者的登记
+				if (write_wait_count_.load(std::memory_order_relaxed) > 0) [[unlikely]] {
+					signal_writer();
+				} else if (read_wait_count_.load(std::memory_order_relaxed) > 0) [[unlikely]] {
+					signal_readers();
+				}
+			} else {
+				// --- 释放读锁逻辑 ---
+				release_shared(1);
+			}
+		}
+
+		// ================== 读锁 (Shared Lock) ==================
+
+		[[nodiscard]] inline bool try_lock_shared() noexcept {
+			if (try_acquire_shared()) {
+				site_.acquired(this);
+				return true;
+			}
+			return false;
+		}
+
+		inline void lock_shared() noexcept {
+			if (try_acquire_shared()) [[likely]] {
+				site_.acquired(this);
+				return;
+			}
+			u64 start = site_.wait_start();
+			bool parked = false;
+			lock_reader<false>({}, parked);
+			site_.acquired_contended(this, start, parked);
+		}
+
+		// 限时加读锁：超时返回 false，放弃时等待计数已减回
+		template <typename Rep, typename Period>
+		[[nodiscard]] inline bool try_lock_shared_for(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+			return try_lock_shared_until_steady(thread::futex_deadline_after(timeout));
+		}
+
+		template <typename Clock, typename Duration>
+		[[nodiscard]] inline bool try_lock_shared_until(const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+			return try_lock_shared_until_steady(thread::to_futex_deadline(deadline));
+		}
+
+		// 显式命名的读解锁
+		inline void unlock_shared() noexcept {
+			unlock();
+		}
+
+		// ================== 可升级读锁 (Upgrade Lock) ==================
+		/**
+		 * 可升级读锁与普通读者共存、与写者互斥，同一时刻最多一个持有者；
+		 * upgrade_to_unique() 置位升级中位挡住新读者，只等已有的读者离开即转为写锁，
+		 * 期间不释放读锁，不会有其他写者插队。必须用 unlock_upgrade() 释放（unlock() 无法区分升级者）。
+		 */
+
+		[[nodiscard]] inline bool try_lock_upgrade() noexcept {
+			if (try_acquire_upgrade()) {
+				site_.acquired(this);
+				return true;
+			}
+			return false;
+		}
+
+		inline void lock_upgrade() noexcept {
+			if (try_acquire_upgrade()) [[likely]] {
+				site_.acquired(this);
+				return;
+			}
+			u64 start = site_.wait_start();
+			bool parked = false;
+			lock_reader<false, true>({}, parked);
+			site_.acquired_contended(this, start, parked);
+		}
+
+		inline void unlock_upgrade() noexcept {
+			site_.released(this);
+			release_shared(1 + upgrade_bit);
+			// 升级位已释放，唤醒等待可升级读锁的线程
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (read_wait_count_.load(std::memory_order_relaxed) > 0) [[unlikely]] {
+				signal_readers();
+			}
+		}
+
+		// 可升级读锁 → 写锁：等待其他读者离开
+		inline void upgrade_to_unique() noexcept {
+			i32 state = lock_state_.fetch_or(upgrading_bit, std::memory_order_seq_cst) | upgrading_bit;
+			detail::backoff<config> bo;
+			while (true) {
+				if ((state & reader_mask) == 1) {
+					if (lock_state_.compare_exchange_weak(state, write_locked_bit | (state & write_pending_bit),
+														  std::memory_order_acquire,
+														  std::memory_order_relaxed)) {
 						return;
 					}
-					if (std::chrono::steady_clock::now() - t1 > dur) {
-						goto wait_code;
-					}
+					continue;
 				}
-				// 2. 慢速尝试
-				while (true) {
-					// 1. 尝试获取
-					if (try_lock()) [[likely]] {
-						return;
-					}
-					// 2. 尝试等待
-					if (std::chrono::steady_clock::now() - t1 < std::chrono::nanoseconds(config.wait_threshold_ns_)) [[likely]] {
-						// 1. 指数回避
-						while (std::chrono::steady_clock::now() - t1 < std::chrono::nanoseconds(config.wait_threshold_ns_) - dur) {
-							cpu::relax();
-						}
-					} else {
-					wait_code:
-						// 2. 系统等待
-						if (is_add_wait == false) [[likely]] {
-							wait_count_.fetch_add(1, std::memory_order_relaxed);
-							is_add_wait = true;
-						}
-						while (flag_.load(std::memory_order_relaxed) == true) {
-							flag_.wait(true, std::memory_order_relaxed);
-						}
-						wait_count_.fetch_sub(1, std::memory_order_relaxed);
+				if (bo.spinning()) [[likely]] {
+					bo.spin();
+					bo.next();
+				} else {
+					u32 old_sig = upgrade_signal_.load(std::memory_order_seq_cst);
+					state = lock_state_.load(std::memory_order_seq_cst);
+					if ((state & reader_mask) != 1) {
+						thread::futex_wait(upgrade_signal_, old_sig);
 					}
-					dur *= 2;
 				}
+				state = lock_state_.load(std::memory_order_relaxed);
 			}
 		}
 
-		inline void unlock() noexcept {
-			flag_.store(false, std::memory_order_release);
+		/**
+		 * @brief 写锁 → 读锁，期间不会有其他写者插入
+		 * 写者挂起位只在仍有登记的写者时保留；没有写者等待时唤醒被写锁挡住的读者
+		 */
+		inline void downgrade() noexcept {
+			bool has_writer = write_wait_count_.load(std::memory_order_relaxed) > 0;
+			lock_state_.store(1 | (has_writer ? write_pending_bit : 0), std::memory_order_seq_cst);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
 
-			// 如果有等待者，发出通知
-			if (wait_count_.load(std::memory_order_relaxed) > 0) [[unlikely]] {
-				flag_.notify_one();
+			if (write_wait_count_.load(std::memory_order_relaxed) > 0) {
+				// 写者可能在读取 has_writer 之后才登记：置回挂起位，最后一个读者离开时会唤醒它
+				lock_state_.fetch_or(write_pending_bit, std::memory_order_seq_cst);
+			} else if (read_wait_count_.load(std::memory_order_relaxed) > 0) [[unlikely]] {
+				signal_readers();
 			}
 		}
 
+		// 统计标签（perf_config::profile_ 打开时可用），应在锁被共享前设置
+		inline void set_label(const char *label) noexcept
+			requires(config.profile_)
+		{
+			site_.label_.store(label, std::memory_order_relaxed);
+		}
+
 	private:
-		std::atomic<bool> flag_ = false;
-		std::atomic<u32> wait_count_ = 0;
-	};
-	inline static constexpr u64 mutex_size = sizeof(mutex<>);
+		[[nodiscard]] inline bool try_acquire() noexcept {
+			i32 expected = 0;
+			return lock_state_.compare_exchange_strong(expected, write_locked_bit,
+													   std::memory_order_acquire,
+													   std::memory_order_relaxed);
+		}
 
-	// 递归锁
-	template <perf_config config = perf_config{}>
-	class recursive_mutex {};
-	inline static constexpr u64 recursive_mutex_size = sizeof(recursive_mutex<>);
+		[[nodiscard]] inline bool try_acquire_shared() noexcept {
+			i32 state = lock_state_.load(std::memory_order_relaxed);
+			// 写优先：只要有写锁、写者在 Pending 或升级者在等待，新读者就不能进入
+			if (!(state & (write_locked_bit | write_pending_bit | upgrading_bit))) {
+				if (lock_state_.compare_exchange_weak(state, state + 1,
+													  std::memory_order_acquire,
+													  std::memory_order_relaxed)) {
+					return true;
+				}
+			}
+			return false;
+		}
 
-	// 读写锁
-	template <perf_config config = perf_config{}>
-	class shared_mutex {
-	private:
-		inline static constexpr i32 write_locked_bit = 1 << 31;
-		inline static constexpr i32 write_pending_bit = 1 << 30;
-		inline static constexpr i32 reader_mask = 0x3FFFFFFF;
+		[[nodiscard]] inline bool try_acquire_upgrade() noexcept {
+			i32 state = lock_state_.load(std::memory_order_relaxed);
+			if (!(state & (write_locked_bit | write_pending_bit | upgrade_bit | upgrading_bit))) {
+				if (lock_state_.compare_exchange_weak(state, state + 1 + upgrade_bit,
+													  std::memory_order_acquire,
+													  std::memory_order_relaxed)) {
+					return true;
+				}
+			}
+			return false;
+		}
 
 		/**
-		 * lock_state_ 布局:
-		 * [31位]: 写锁位 | [30位]: 写者挂起位 | [0-29位]: 读者计数
+		 * @brief 释放读者计数（可升级读锁连同升级位）
+		 * - 最后一个读者离开且有写者挂起时唤醒写者
+		 * - 普通读者离开后只剩升级者、且升级者已置升级中位（可能在 upgrade_to_unique 中等待）时唤醒它
 		 */
-		std::atomic<i32> lock_state_{0};
-
-		// 唤醒版本号：使用独立缓存行防止伪共享
-		std::atomic<u32> write_signal_{0};
-		std::atomic<u32> read_signal_{0};
+		inline void release_shared(i32 delta) noexcept {
+			i32 prev = lock_state_.fetch_sub(delta, std::memory_order_seq_cst);
+			i32 readers = prev & reader_mask;
 
-		// 等待线程计数
-		std::atomic<u16> write_wait_count_{0};
-		std::atomic<u16> read_wait_count_{0};
+			// 如果是最后一个读者，且有写者在排队
+			if (readers == 1 && (prev & write_pending_bit)) {
+				// 同样使用 seq_cst 思想确保唤醒不丢失
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (write_wait_count_.load(std::memory_order_relaxed) > 0) {
+					signal_writer();
+				}
+			} else if (readers == 2 && delta == 1 && (prev & upgrading_bit)) [[unlikely]] {
+				upgrade_signal_.fetch_add(1, std::memory_order_seq_cst);
+				thread::futex_wake_one(upgrade_signal_);
+			}
+		}
 
-	public:
-		// ================== 写锁 (Exclusive Lock) ==================
+		[[nodiscard]] inline bool try_acquire_pending() noexcept {
+			i32 state = lock_state_.load(std::memory_order_relaxed);
+			// 尝试抢占：必须没有写锁且读者为0
+			while ((state & (write_locked_bit | reader_mask)) == 0) {
+				if (lock_state_.compare_exchange_weak(state, write_locked_bit | (state & write_pending_bit),
+													  std::memory_order_acquire,
+													  std::memory_order_relaxed)) {
+					return true;
+				}
+			}
+			return false;
+		}
 
-		[[nodiscard]] inline bool try_lock() noexcept {
-			i32 expected = 0;
-			return lock_state_.compare_exchange_strong(expected, write_locked_bit,
-													   std::memory_order_acquire,
-													   std::memory_order_relaxed);
+		inline void signal_writer() noexcept {
+			write_signal_.fetch_add(1, std::memory_order_relaxed);
+			thread::futex_wake_one(write_signal_);
 		}
 
-		inline void lock() noexcept {
-			if (try_lock()) [[likely]]
-				return;
+		inline void signal_readers() noexcept {
+			read_signal_.fetch_add(1, std::memory_order_relaxed);
+			thread::futex_wake_all(read_signal_);
+		}
 
+		/**
+		 * @brief 写者竞争路径
+		 * 挂起前重新置位 pending（写解锁可能在登记前把它清掉），最后一个读者据此唤醒写者；
+		 * 登记、置位与解锁方的 store / fence 都是 seq_cst，不会同时错过对方
+		 */
+		template <bool timed>
+		CHENC_NO_INLINE bool lock_writer(thread::futex_clock::time_point deadline, bool &parked) noexcept {
 			// 1. 设置写者挂起位（写者优先策略）
 			lock_state_.fetch_or(write_pending_bit, std::memory_order_relaxed);
 
-			auto t1 = std::chrono::steady_clock::now();
-			auto dur = std::chrono::nanoseconds(config.start_sleep_ns_);
-			bool is_add_wait = false;
-
-			while (true) {
-				i32 state = lock_state_.load(std::memory_order_relaxed);
-
-				// 尝试抢占：必须没有写锁且读者为0
-				if ((state & (write_locked_bit | reader_mask)) == 0) {
-					if (lock_state_.compare_exchange_strong(state,
-															write_locked_bit | (state & write_pending_bit),
-															std::memory_order_acquire)) {
-						break;
+			detail::backoff<config> bo;
+			while (!try_acquire_pending()) {
+				if constexpr (timed) {
+					if (thread::futex_clock::now() >= deadline) {
+						return abandon_writer(parked);
 					}
 				}
-
-				auto elapsed = std::chrono::steady_clock::now() - t1;
-				if (elapsed < std::chrono::nanoseconds(config.wait_threshold_ns_)) [[likely]] {
+				if (!parked && bo.spinning()) [[likely]] {
 					// 指数回避逻辑：模仿你的 mutex
-					auto target = t1 + std::chrono::nanoseconds(config.wait_threshold_ns_) - dur;
-					while (std::chrono::steady_clock::now() < target) {
-						cpu::relax();
-					}
+					bo.spin();
 				} else {
 					// 进入系统挂起路径
-					if (!is_add_wait) [[likely]] {
-						write_wait_count_.fetch_add(1, std::memory_order_relaxed);
-						is_add_wait = true;
+					if (!parked) [[likely]] {
+						write_wait_count_.fetch_add(1, std::memory_order_seq_cst);
+						parked = true;
 					}
 
-					u32 old_sig = write_signal_.load(std::memory_order_relaxed);
-					state = lock_state_.load(std::memory_order_relaxed);
+					u32 old_sig = write_signal_.load(std::memory_order_seq_cst);
+					i32 state = lock_state_.fetch_or(write_pending_bit, std::memory_order_seq_cst);
 
 					// 双重检查：如果锁依然被占用，则真正进入等待
 					if ((state & (write_locked_bit | reader_mask)) != 0) {
-						write_signal_.wait(old_sig, std::memory_order_relaxed);
+						if constexpr (timed) {
+							thread::futex_wait_until(write_signal_, old_sig, deadline);
+						} else {
+							thread::futex_wait(write_signal_, old_sig);
+						}
 					}
 				}
-				dur *= 2;
+				bo.next();
 			}
 
-			if (is_add_wait)
+			if (parked)
 				write_wait_count_.fetch_sub(1, std::memory_order_relaxed);
+			return true;
 		}
 
 		/**
-		 * @brief 统一解锁函数
+		 * @brief 写者超时放弃
+		 * 最后尝试一次，失败说明锁此刻被持有，其解锁会照常唤醒剩余写者。
+		 * 没有登记的写者时清掉 pending 并唤醒读者；清除后若发现有写者恰好登记，再置回并唤醒它
 		 */
-		inline void unlock() noexcept {
-			i32 state = lock_state_.load(std::memory_order_relaxed);
+		inline bool abandon_writer(bool parked) noexcept {
+			if (parked) {
+				write_wait_count_.fetch_sub(1, std::memory_order_seq_cst);
+			}
+			if (try_acquire_pending()) {
+				return true;
+			}
+			if (write_wait_count_.load(std::memory_order_seq_cst) == 0) {
+				lock_state_.fetch_and(~write_pending_bit, std::memory_order_seq_cst);
+				if (write_wait_count_.load(std::memory_order_seq_cst) > 0) [[unlikely]] {
+					lock_state_.fetch_or(write_pending_bit, std::memory_order_seq_cst);
+					signal_writer();
+				} else if (read_wait_count_.load(std::memory_order_seq_cst) > 0) {
+					signal_readers();
+				}
+			}
+			return false;
+		}
 
-			if (state & write_locked_bit) {
-				// --- 释放写锁逻辑 ---
-				bool has_writer = (write_wait_count_.load(std::memory_order_relaxed) > 0);
+		// 读者（upgrade 时为可升级读者）竞争路径
+		template <bool timed, bool upgrade = false>
+		CHENC_NO_INLINE bool lock_reader(thread::futex_clock::time_point deadline, bool &parked) noexcept {
+			constexpr i32 blocked_mask = write_locked_bit | write_pending_bit | upgrading_bit | (upgrade ? upgrade_bit : 0);
+			auto try_acquire_reader = [this]() noexcept {
+				if constexpr (upgrade) {
+					return try_acquire_upgrade();
+				} else {
+					return try_acquire_shared();
+				}
+			};
 
-				// 1. 释放锁。如果有写者在等，保留 pending 位
-				lock_state_.store(has_writer ? write_pending_bit : 0, std::memory_order_release);
+			detail::backoff<config> bo;
+			while (!try_acquire_reader()) {
+				if constexpr (timed) {
+					if (thread::futex_clock::now() >= deadline) {
+						if (parked) {
+							read_wait_count_.fetch_sub(1, std::memory_order_relaxed);
+						}
+						return try_acquire_reader();
+					}
+				}
+				if (!parked && bo.spinning()) [[likely]] {
+					bo.spin();
+				} else {
+					if (!parked) [[likely]] {
+						read_wait_count_.fetch_add(1, std::memory_order_seq_cst);
+						parked = true;
+					}
 
-				// 2. 关键：全内存屏障。确保上面的 store 对所有 CPU 可见后，再读取 wait_count
-				std::atomic_thread_fence(std::memory_order_seq_cst);
+					u32 old_sig = read_signal_.load(std::memory_order_seq_cst);
+					i32 state = lock_state_.load(std::memory_order_seq_cst);
 
-				if (has_writer) [[unlikely]] {
-					write_signal_.fetch_add(1, std::memory_order_relaxed);
-					write_signal_.notify_one();
-				} else if (read_wait_count_.load(std::memory_order_relaxed) > 0) [[unlikely]] {
-					read_signal_.fetch_add(1, std::memory_order_relaxed);
-					read_signal_.notify_all();
+					// 只要有写者竞争，读者就挂起
+					if (state & blocked_mask) {
+						if constexpr (timed) {
+							thread::futex_wait_until(read_signal_, old_sig, deadline);
+						} else {
+							thread::futex_wait(read_signal_, old_sig);
+						}
+					}
 				}
-			} else {
-				// --- 释放读锁逻辑 ---
-				i32 prev = lock_state_.fetch_sub(1, std::memory_order_release);
-
-				// 如果是最后一个读者，且有写者在排队
-				if (((prev & reader_mask) == 1) && (prev & write_pending_bit)) {
-					// 同样使用 seq_cst 思想确保唤醒不丢失
-					std::atomic_thread_fence(std::memory_order_seq_cst);
-					if (write_wait_count_.load(std::memory_order_relaxed) > 0) {
-						write_signal_.fetch_add(1, std::memory_order_relaxed);
-						write_signal_.notify_one();
+				bo.next();
+			}
+
+			if (parked)
+				read_wait_count_.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		inline bool try_lock_until_steady(thread::futex_clock::time_point deadline) noexcept {
+			if (try_acquire()) [[likely]] {
+				site_.acquired(this);
+				return true;
+			}
+			u64 start = site_.wait_start();
+			bool parked = false;
+			if (!lock_writer<true>(deadline, parked)) {
+				return false;
+			}
+			site_.acquired_contended(this, start, parked);
+			return true;
+		}
+
+		inline bool try_lock_shared_until_steady(thread::futex_clock::time_point deadline) noexcept {
+			if (try_acquire_shared()) [[likely]] {
+				site_.acquired(this);
+				return true;
+			}
+			u64 start = site_.wait_start();
+			bool parked = false;
+			if (!lock_reader<true>(deadline, parked)) {
+				return false;
+			}
+			site_.acquired_contended(this, start, parked);
+			return true;
+		}
+
+		[[no_unique_address]] detail::lock_site<config.profile_> site_;
+	};
+	inline static constexpr u64 shared_mutex_size = sizeof(shared_mutex<>);
+
+	/**
+	 * @brief 读偏向的分布式读写锁（BRAVO）
+	 * - 读偏向开启时，读者在自己的槽位（按 thread::this_id() 选择、独占缓存行）上 CAS 写入自己的 id，
+	 *   不触碰任何共享缓存行，读侧随核数线性扩展
+	 * - 写者先取得底层 shared_mutex 的写锁，撤销读偏向，再扫描所有槽位等待快速路径上的读者离开
+	 * - 撤销代价按耗时的 inhibit_multiplier 倍抑制读偏向，期间读者走底层锁；
+	 *   抑制期过后由慢速路径上的读者重新开启偏向，写多时退化为普通 shared_mutex
+	 * - 槽位冲突时走底层锁，unlock_shared 通过槽位中的 id 区分两条路径
+	 * 与 std::shared_mutex 一样不支持同一线程重复加读锁（有写者等待时会死锁）。
+	 * 每个锁占 slot_count 条缓存行，适合少量读多写少的热点锁。
+	 */
+	template <perf_config config = perf_config{}, u64 slot_count = 64>
+	class distributed_shared_mutex {
+		static_assert(std::has_single_bit(slot_count), "slot_count must be a power of two");
+
+	private:
+		inline static constexpr u64 inhibit_multiplier = 9;
+
+		struct CHENC_CACHE_ALIGN slot {
+			std::atomic<u64> owner_{0}; // 持有读锁的 thread::this_id() + 1，0 表示空闲
+		};
+
+		inline static u64 self_tag() noexcept { return thread::this_id() + 1; }
+		inline static slot &slot_of(slot *slots, u64 tag) noexcept { return slots[(tag - 1) & (slot_count - 1)]; }
+
+	public:
+		// ================== 写锁 ==================
+
+		[[nodiscard]] inline bool try_lock() noexcept {
+			if (!underlying_.try_lock()) {
+				return false;
+			}
+			if (rbias_.load(std::memory_order_relaxed)) {
+				u64 start = cpu::cycle_clock::get().now();
+				rbias_.store(false, std::memory_order_seq_cst);
+				// 槽位读取必须是 seq_cst：seq_cst 写之后的 acquire 读不受全序约束，可以提前到写之前
+				for (slot &s : slots_) {
+					if (s.owner_.load(std::memory_order_seq_cst) != 0) {
+						// 仍有快速路径读者：保持偏向撤销，本次失败
+						inhibit(start);
+						underlying_.unlock();
+						return false;
 					}
 				}
+				inhibit(start);
 			}
+			return true;
 		}
 
-		// ================== 读锁 (Shared Lock) ==================
+		inline void lock() noexcept {
+			underlying_.lock();
+			if (rbias_.load(std::memory_order_relaxed)) [[unlikely]] {
+				revoke();
+			}
+		}
+
+		inline void unlock() noexcept {
+			underlying_.unlock();
+		}
+
+		// ================== 读锁 ==================
 
 		[[nodiscard]] inline bool try_lock_shared() noexcept {
-			i32 state = lock_state_.load(std::memory_order_relaxed);
-			// 写优先：只要有写锁或写者在 Pending，新读者就不能进入
-			if (!(state & (write_locked_bit | write_pending_bit))) {
-				if (lock_state_.compare_exchange_weak(state, state + 1,
-													  std::memory_order_acquire,
-													  std::memory_order_relaxed)) {
-					return true;
-				}
+			if (try_lock_fast()) [[likely]] {
+				return true;
 			}
-			return false;
+			if (!underlying_.try_lock_shared()) {
+				return false;
+			}
+			maybe_rebias();
+			return true;
 		}
 
 		inline void lock_shared() noexcept {
-			if (try_lock_shared()) [[likely]]
+			if (try_lock_fast()) [[likely]] {
 				return;
+			}
+			underlying_.lock_shared();
+			maybe_rebias();
+		}
 
-			auto t1 = std::chrono::steady_clock::now();
-			auto dur = std::chrono::nanoseconds(config.start_sleep_ns_);
-			bool is_add_wait = false;
+		inline void unlock_shared() noexcept {
+			u64 tag = self_tag();
+			slot &s = slot_of(slots_, tag);
+			if (s.owner_.load(std::memory_order_relaxed) == tag) [[likely]] {
+				s.owner_.store(0, std::memory_order_release);
+				return;
+			}
+			underlying_.unlock_shared();
+		}
 
-			while (true) {
-				if (try_lock_shared())
-					break;
+	private:
+		// 快速路径：占用自己的槽位后复查偏向，与写者的撤销构成 Dekker 对
+		inline bool try_lock_fast() noexcept {
+			if (!rbias_.load(std::memory_order_acquire)) {
+				return false;
+			}
+			u64 tag = self_tag();
+			slot &s = slot_of(slots_, tag);
+			u64 expected = 0;
+			if (!s.owner_.compare_exchange_strong(expected, tag, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return false;
+			}
+			if (rbias_.load(std::memory_order_seq_cst)) [[likely]] {
+				return true;
+			}
+			s.owner_.store(0, std::memory_order_release);
+			return false;
+		}
+
+		// 持有底层读锁时（没有写者）按需重新开启偏向
+		inline void maybe_rebias() noexcept {
+			if (!rbias_.load(std::memory_order_relaxed) &&
+				cpu::cycle_clock::get().now() >= inhibit_until_.load(std::memory_order_relaxed)) {
+				rbias_.store(true, std::memory_order_release);
+			}
+		}
 
-				auto elapsed = std::chrono::steady_clock::now() - t1;
-				if (elapsed < std::chrono::nanoseconds(config.wait_threshold_ns_)) [[likely]] {
-					auto target = t1 + std::chrono::nanoseconds(config.wait_threshold_ns_) - dur;
-					while (std::chrono::steady_clock::now() < target) {
+		// 撤销读偏向并等待快速路径上的读者全部离开
+		CHENC_NO_INLINE void revoke() noexcept {
+			u64 start = cpu::cycle_clock::get().now();
+			rbias_.store(false, std::memory_order_seq_cst);
+			for (slot &s : slots_) {
+				u32 spins = 0;
+				while (s.owner_.load(std::memory_order_seq_cst) != 0) {
+					if (++spins < 64) {
 						cpu::relax();
+					} else {
+						std::this_thread::yield();
 					}
-				} else {
-					if (!is_add_wait) [[likely]] {
-						read_wait_count_.fetch_add(1, std::memory_order_relaxed);
-						is_add_wait = true;
-					}
+				}
+			}
+			inhibit(start);
+		}
 
-					u32 old_sig = read_signal_.load(std::memory_order_relaxed);
-					i32 state = lock_state_.load(std::memory_order_relaxed);
+		inline void inhibit(u64 start) noexcept {
+			u64 now = cpu::cycle_clock::get().now();
+			inhibit_until_.store(now + (now - start) * inhibit_multiplier, std::memory_order_relaxed);
+		}
 
-					// 只要有写者竞争，读者就挂起
-					if (state & (write_locked_bit | write_pending_bit)) {
-						read_signal_.wait(old_sig, std::memory_order_relaxed);
-					}
+	private:
+		CHENC_CACHE_ALIGN std::atomic<bool> rbias_{true};
+		std::atomic<u64> inhibit_until_{0};
+		CHENC_CACHE_ALIGN shared_mutex<config> underlying_;
+		slot slots_[slot_count];
+	};
+	inline static constexpr u64 distributed_shared_mutex_size = sizeof(distributed_shared_mutex<>);
+
+	/**
+	 * @brief NUMA 感知的分层（cohort）独占锁
+	 * - 每个 NUMA 节点一把本地 mutex<config>（独占缓存行），外加一把全局 mutex<config>
+	 * - 加锁先取当前节点的本地锁；本节点的 cohort 尚未持有全局锁时再取全局锁
+	 * - 解锁时若本节点还有线程在等本地锁、且连续交接未满 batch_limit 次，只释放本地锁，
+	 *   全局锁留给本节点的下一个持有者，锁与受保护数据一直留在本 socket 的缓存里；
+	 *   否则先释放全局锁再释放本地锁，让其他节点有机会获得
+	 * 全局锁可能由另一个线程释放，mutex<> 不记录持有者，满足这一要求。
+	 * 单节点机器上只多一次本地锁开销；节点数在构造时从 cpu::topology 读取。
+	 */
+	template <perf_config config = perf_config{}, u32 batch_limit = 64>
+	class cohort_mutex {
+		static_assert(batch_limit > 0, "batch_limit must be positive");
+
+	private:
+		struct CHENC_CACHE_ALIGN local_lock {
+			mutex<config> mtx_;
+			std::atomic<u32> waiting_{0}; // 正在等待本地锁的线程数
+			bool global_held_ = false;	  // 本节点 cohort 持有全局锁（由 mtx_ 保护）
+			u32 batch_ = 0;				  // 本节点内连续交接次数（由 mtx_ 保护）
+		};
+
+	public:
+		cohort_mutex()
+			: node_count_(std::max<u64>(1, cpu::topology::get().node_count())),
+			  locals_(std::make_unique<local_lock[]>(node_count_)) {}
+
+		cohort_mutex(const cohort_mutex &) = delete;
+		cohort_mutex &operator=(const cohort_mutex &) = delete;
+
+		[[nodiscard]] inline bool try_lock() noexcept {
+			u64 node = current_node();
+			local_lock &l = locals_[node];
+			if (!l.mtx_.try_lock()) {
+				return false;
+			}
+			if (!l.global_held_) {
+				if (!global_.try_lock()) {
+					l.mtx_.unlock();
+					return false;
 				}
-				dur *= 2;
+				l.global_held_ = true;
+				l.batch_ = 0;
 			}
+			owner_node_ = node;
+			return true;
+		}
 
-			if (is_add_wait)
-				read_wait_count_.fetch_sub(1, std::memory_order_relaxed);
+		inline void lock() noexcept {
+			u64 node = current_node();
+			local_lock &l = locals_[node];
+			if (!l.mtx_.try_lock()) {
+				l.waiting_.fetch_add(1, std::memory_order_relaxed);
+				l.mtx_.lock();
+				l.waiting_.fetch_sub(1, std::memory_order_relaxed);
+			}
+			if (!l.global_held_) {
+				global_.lock();
+				l.global_held_ = true;
+				l.batch_ = 0;
+			}
+			owner_node_ = node;
 		}
 
-		// 显式命名的读解锁
-		inline void unlock_shared() noexcept {
-			unlock();
+		inline void unlock() noexcept {
+			local_lock &l = locals_[owner_node_];
+			if (l.waiting_.load(std::memory_order_relaxed) > 0 && ++l.batch_ < batch_limit) {
+				// 节点内交接：全局锁留给本节点的下一个持有者
+				l.mtx_.unlock();
+				return;
+			}
+			l.global_held_ = false;
+			global_.unlock();
+			l.mtx_.unlock();
+		}
+
+		inline u64 node_count() const noexcept { return node_count_; }
+
+	private:
+		// 线程可能在加锁后迁移到其他节点，所以记录加锁时使用的节点，而不是解锁时重新查询
+		inline u64 current_node() const noexcept {
+			return node_count_ == 1 ? 0 : cpu::current_node() % node_count_;
 		}
+
+		mutex<config> global_;
+		u64 owner_node_ = 0; // 当前持有者使用的本地锁下标（由锁本身保护）
+		const u64 node_count_;
+		std::unique_ptr<local_lock[]> locals_;
+	};
+
+	/**
+	 * @brief 顺序锁：小型只读为主数据的乐观版本读
+	 * - 读者只做读取：读版本号 → 逐字读取数据 → acquire 栅栏 → 复查版本号，期间有写入则重试
+	 * - 写者由 mutex<config> 串行化：版本号置奇数 → release 栅栏 → 逐字写入 → 版本号置偶数（release）
+	 * - 数据按 8 字节字存放，双方都通过 std::atomic_ref 以 relaxed 方式访问，并发读写不构成数据竞争；
+	 *   写者在锁内读取旧值时不会与其他写者并发，直接读取
+	 * 写入频繁或 T 较大时读者可能反复重试，此时应使用读写锁。
+	 */
+	template <typename T, perf_config config = perf_config{}>
+		requires std::is_trivially_copyable_v<T>
+	class seqlock {
+	private:
+		inline static constexpr u64 word_count = (sizeof(T) + sizeof(u64) - 1) / sizeof(u64);
+		using words_t = std::array<u64, word_count>;
+
+	public:
+		seqlock() noexcept
+			requires std::is_default_constructible_v<T>
+			: seqlock(T{}) {}
+
+		explicit seqlock(const T &value) noexcept {
+			words_ = to_words(value);
+		}
+
+		seqlock(const seqlock &) = delete;
+		seqlock &operator=(const seqlock &) = delete;
+
+		// ================== 读 ==================
+
+		// 读取一致的快照；写入进行中时自旋等待
+		[[nodiscard]] inline T load() const noexcept {
+			T out = from_words(words_t{});
+			while (!try_load(out)) {
+				cpu::relax();
+			}
+			return out;
+		}
+
+		// 单次尝试；与写入重叠时返回 false，out 不变
+		[[nodiscard]] inline bool try_load(T &out) const noexcept {
+			u64 seq = seq_.load(std::memory_order_acquire);
+			if (seq & 1) {
+				return false;
+			}
+			words_t buf;
+			for (u64 i = 0; i < word_count; i++) {
+				buf[i] = std::atomic_ref<u64>(words_[i]).load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq_.load(std::memory_order_relaxed) != seq) {
+				return false;
+			}
+			out = from_words(buf);
+			return true;
+		}
+
+		// 当前版本号（每次写入加 2，奇数表示写入进行中）
+		[[nodiscard]] inline u64 version() const noexcept { return seq_.load(std::memory_order_acquire); }
+
+		// ================== 写 ==================
+
+		inline void store(const T &value) noexcept {
+			std::scoped_lock guard(mtx_);
+			publish(to_words(value));
+		}
+
+		// 在写锁内以旧值调用 f(T&) 并发布修改后的值
+		template <typename F>
+		inline void update(F &&f) {
+			std::scoped_lock guard(mtx_);
+			T value = from_words(words_);
+			std::forward<F>(f)(value);
+			publish(to_words(value));
+		}
+
+	private:
+		inline static words_t to_words(const T &value) noexcept {
+			words_t w{};
+			std::memcpy(w.data(), &value, sizeof(T));
+			return w;
+		}
+
+		inline static T from_words(const words_t &w) noexcept {
+			std::array<std::byte, sizeof(T)> bytes;
+			std::memcpy(bytes.data(), w.data(), sizeof(T));
+			return std::bit_cast<T>(bytes);
+		}
+
+		inline void publish(const words_t &w) noexcept {
+			u64 seq = seq_.load(std::memory_order_relaxed);
+			seq_.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (u64 i = 0; i < word_count; i++) {
+				std::atomic_ref<u64>(words_[i]).store(w[i], std::memory_order_relaxed);
+			}
+			seq_.store(seq + 2, std::memory_order_release);
+		}
+
+	private:
+		CHENC_CACHE_ALIGN std::atomic<u64> seq_{0};
+		alignas(std::atomic_ref<u64>::required_alignment) mutable words_t words_{};
+		mutex<config> mtx_;
 	};
-	inline static constexpr u64 shared_mutex_size = sizeof(shared_mutex<>);
 } // namespace chenc::lock
\ No newline at end of file
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/cpu/time.hpp"
+#include "chenc/core/type.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace chenc::lock {
+	/**
+	 * @brief 一把锁（或同一地址、同一标签的一组锁）的合并统计
+	 * 持有时长按 1/hold_sample_period 的比例抽样，histogram 第 i 桶统计 [2^(i+5), 2^(i+6)) ns，
+	 * 第 0 桶包含 64ns 以下，最后一桶包含所有更长的持有
+	 */
+	struct lock_stats {
+		inline static constexpr u64 histogram_size = 16;
+
+		const void *address_ = nullptr; // 锁地址；单线程记录表溢出时为 nullptr
+		const char *label_ = nullptr;	// set_label 设置的标签
+
+		u64 acquisitions_ = 0; // 获取次数（含 try_lock 成功、读锁）
+		u64 contended_ = 0;	   // 进入竞争路径的次数
+		u64 wait_ns_ = 0;	   // 竞争路径总耗时（自旋 + 挂起）
+		u64 parks_ = 0;		   // 竞争路径中挂起过的次数
+
+		u64 hold_samples_ = 0;
+		u64 hold_ns_ = 0; // 抽样持有时长之和
+		std::array<u64, histogram_size> hold_histogram_{};
+	};
+
+	namespace detail {
+		// 只由所属线程写入，snapshot 并发读取：relaxed 读写即可，不需要 RMW
+		CHENC_FORCE_INLINE void bump(std::atomic<u64> &c, u64 n = 1) noexcept {
+			c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		}
+
+		struct lock_record {
+			std::atomic<const void *> address_{nullptr};
+			std::atomic<const char *> label_{nullptr};
+			std::atomic<u64> acquisitions_{0};
+			std::atomic<u64> contended_{0};
+			std::atomic<u64> wait_ns_{0};
+			std::atomic<u64> parks_{0};
+			std::atomic<u64> hold_samples_{0};
+			std::atomic<u64> hold_ns_{0};
+			std::atomic<u64> hold_histogram_[lock_stats::histogram_size]{};
+			u64 hold_start_ = 0; // 本线程本次持有的抽样起点，0 表示未抽样
+
+			inline void merge_into(lock_stats &s) const noexcept {
+				s.acquisitions_ += acquisitions_.load(std::memory_order_relaxed);
+				s.contended_ += contended_.load(std::memory_order_relaxed);
+				s.wait_ns_ += wait_ns_.load(std::memory_order_relaxed);
+				s.parks_ += parks_.load(std::memory_order_relaxed);
+				s.hold_samples_ += hold_samples_.load(std::memory_order_relaxed);
+				s.hold_ns_ += hold_ns_.load(std::memory_order_relaxed);
+				for (u64 i = 0; i < lock_stats::histogram_size; i++) {
+					s.hold_histogram_[i] += hold_histogram_[i].load(std::memory_order_relaxed);
+				}
+			}
+		};
+
+		class thread_lock_records;
+
+		// 所有线程记录表的登记处；线程退出时把它的统计并入 retired_
+		class lock_profiler_registry {
+		public:
+			using key = std::pair<const void *, const char *>;
+
+			// 有意不析构：静态析构之后退出的线程（全局线程池的 worker、分离线程）仍会登记退出
+			inline static lock_profiler_registry &get() noexcept {
+				static lock_profiler_registry *registry = new lock_profiler_registry;
+				return *registry;
+			}
+
+			std::mutex mtx_;
+			std::vector<thread_lock_records *> live_;
+			std::map<key, lock_stats> retired_;
+		};
+
+		/**
+		 * @brief 每线程的锁统计表
+		 * 按锁地址开放寻址，容量固定、从不扩容，所以 snapshot 可以与所属线程并发遍历；
+		 * 表满后新出现的锁计入地址为 nullptr 的溢出记录。
+		 * 记住上一次命中的记录，同一把锁的加锁与解锁通常只查一次表。
+		 */
+		class thread_lock_records {
+		public:
+			inline static constexpr u64 capacity = 128;
+
+			thread_lock_records() {
+				lock_profiler_registry &reg = lock_profiler_registry::get();
+				std::scoped_lock guard(reg.mtx_);
+				reg.live_.push_back(this);
+			}
+
+			~thread_lock_records() {
+				lock_profiler_registry &reg = lock_profiler_registry::get();
+				std::scoped_lock guard(reg.mtx_);
+				std::erase(reg.live_, this);
+				merge_into(reg.retired_);
+			}
+
+			thread_lock_records(const thread_lock_records &) = delete;
+			thread_lock_records &operator=(const thread_lock_records &) = delete;
+
+			inline static thread_lock_records &local() noexcept {
+				static thread_local thread_lock_records records;
+				return records;
+			}
+
+			CHENC_FORCE_INLINE lock_record &find(const void *addr) noexcept {
+				if (last_addr_ == addr) [[likely]] {
+					return *last_;
+				}
+				return find_slow(addr);
+			}
+
+			inline void merge_into(std::map<lock_profiler_registry::key, lock_stats> &out) const {
+				auto merge = [&out](const lock_record &r) {
+					const void *addr = r.address_.load(std::memory_order_acquire);
+					const char *label = r.label_.load(std::memory_order_relaxed);
+					lock_stats &s = out[{addr, label}];
+					s.address_ = addr;
+					s.label_ = label;
+					r.merge_into(s);
+				};
+				for (const lock_record &r : records_) {
+					if (r.address_.load(std::memory_order_acquire) != nullptr) {
+						merge(r);
+					}
+				}
+				if (overflow_.acquisitions_.load(std::memory_order_relaxed) != 0) {
+					merge(overflow_);
+				}
+			}
+
+		private:
+			CHENC_NO_INLINE lock_record &find_slow(const void *addr) noexcept {
+				u64 h = (u64(reinterpret_cast<uintptr_t>(addr)) >> 3) * 0x9E37'79B9'7F4A'7C15ull;
+				u64 i = h >> (64 - std::countr_zero(capacity));
+				lock_record *rec = &overflow_;
+				for (u64 n = 0; n < capacity; n++, i = (i + 1) & (capacity - 1)) {
+					const void *cur = records_[i].address_.load(std::memory_order_relaxed);
+					if (cur == addr) {
+						rec = &records_[i];
+						break;
+					}
+					if (cur == nullptr) {
+						// 新记录的计数都是 0，发布地址后 snapshot 才会读取它
+						records_[i].address_.store(addr, std::memory_order_release);
+						rec = &records_[i];
+						break;
+					}
+				}
+				last_addr_ = addr;
+				last_ = rec;
+				return *rec;
+			}
+
+			const void *last_addr_ = nullptr;
+			lock_record *last_ = nullptr;
+			lock_record overflow_;
+			lock_record records_[capacity];
+		};
+	} // namespace detail
+
+	/**
+	 * @brief 锁竞争统计
+	 * 只统计 perf_config::profile_ 打开的锁；未打开的锁不含任何统计代码和成员。
+	 * 各线程写自己的记录表，snapshot() 时才加锁合并（已退出线程的统计也保留），
+	 * 按 (地址, 标签) 区分，同一地址上先后构造的不同锁如果标签相同会被合并。
+	 */
+	class lock_profiler {
+	public:
+		inline static constexpr u32 hold_sample_period = 16; // 持有时长抽样周期，必须为 2 的幂
+
+		// 合并所有线程的统计，按竞争次数降序
+		inline static std::vector<lock_stats> snapshot() {
+			std::map<detail::lock_profiler_registry::key, lock_stats> merged;
+			{
+				detail::lock_profiler_registry &reg = detail::lock_profiler_registry::get();
+				std::scoped_lock guard(reg.mtx_);
+				merged = reg.retired_;
+				for (const detail::thread_lock_records *t : reg.live_) {
+					t->merge_into(merged);
+				}
+			}
+			std::vector<lock_stats> out;
+			out.reserve(merged.size());
+			for (auto &[k, s] : merged) {
+				out.push_back(s);
+			}
+			std::sort(out.begin(), out.end(), [](const lock_stats &a, const lock_stats &b) {
+				return a.contended_ != b.contended_ ? a.contended_ > b.contended_ : a.acquisitions_ > b.acquisitions_;
+			});
+			return out;
+		}
+
+		// ================== 锁内部调用 ==================
+
+		// 获取成功（contended 时 wait_start 为进入竞争路径时的 cycle_clock 读数）
+		inline static void on_acquire(const void *addr, const char *label, bool contended, u64 wait_start,
+									  bool parked) noexcept {
+			detail::lock_record &r = detail::thread_lock_records::local().find(addr);
+			if (r.label_.load(std::memory_order_relaxed) != label) [[unlikely]] {
+				r.label_.store(label, std::memory_order_relaxed);
+			}
+			u64 n = r.acquisitions_.load(std::memory_order_relaxed);
+			r.acquisitions_.store(n + 1, std::memory_order_relaxed);
+			if (contended) {
+				const cpu::cycle_clock &clock = cpu::cycle_clock::get();
+				detail::bump(r.contended_);
+				detail::bump(r.wait_ns_, clock.to_ns(clock.now() - wait_start));
+				if (parked) {
+					detail::bump(r.parks_);
+				}
+			}
+			// 按本线程对这把锁的获取次数抽样，不同锁交替加锁时也不会互相错开
+			r.hold_start_ = (n & (hold_sample_period - 1)) == 0 ? cpu::cycle_clock::get().now() : 0;
+		}
+
+		inline static void on_release(const void *addr) noexcept {
+			detail::lock_record &r = detail::thread_lock_records::local().find(addr);
+			if (r.hold_start_ != 0) [[unlikely]] {
+				const cpu::cycle_clock &clock = cpu::cycle_clock::get();
+				u64 ns = clock.to_ns(clock.now() - r.hold_start_);
+				r.hold_start_ = 0;
+				u64 bucket = std::min<u64>(std::max<u64>(std::bit_width(ns), 6) - 6, lock_stats::histogram_size - 1);
+				detail::bump(r.hold_samples_);
+				detail::bump(r.hold_ns_, ns);
+				detail::bump(r.hold_histogram_[bucket]);
+			}
+		}
+	};
+
+	namespace detail {
+		/**
+		 * @brief 锁内嵌的统计钩子
+		 * 关闭时是空类型，所有调用都是空的内联函数；打开时只多一个标签指针
+		 */
+		template <bool enabled>
+		struct lock_site {
+			CHENC_FORCE_INLINE u64 wait_start() const noexcept { return 0; }
+			CHENC_FORCE_INLINE void acquired(const void *) const noexcept {}
+			CHENC_FORCE_INLINE void acquired_contended(const void *, u64, bool) const noexcept {}
+			CHENC_FORCE_INLINE void released(const void *) const noexcept {}
+		};
+
+		template <>
+		struct lock_site<true> {
+			std::atomic<const char *> label_{nullptr};
+
+			inline u64 wait_start() const noexcept { return cpu::cycle_clock::get().now(); }
+			inline void acquired(const void *addr) const noexcept {
+				lock_profiler::on_acquire(addr, label_.load(std::memory_order_relaxed), false, 0, false);
+			}
+			inline void acquired_contended(const void *addr, u64 start, bool parked) const noexcept {
+				lock_profiler::on_acquire(addr, label_.load(std::memory_order_relaxed), true, start, parked);
+			}
+			inline void released(const void *addr) const noexcept { lock_profiler::on_release(addr); }
+		};
+	} // namespace detail
+} // namespace chenc::lock
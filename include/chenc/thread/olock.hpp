@@ -1,147 +1,206 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <bit>
 #include <chrono>
 #include <semaphore>
 #include <thread>
 
+#include "chenc/core/cpp.hpp"
 #include "chenc/core/cpu/relax.hpp"
+#include "chenc/core/cpu/time.hpp"
 #include "chenc/core/type.hpp"
+#include "chenc/thread/futex.hpp"
 
 namespace chenc {
+	namespace detail {
+		/**
+		 * @brief 限时获取的轮询实现
+		 * rw_lock 的状态字为 64 位，不能直接用 futex 超时等待，改为指数退避地重复 try_lock：
+		 * 先 cpu::relax 翻倍自旋，之后 yield，直到成功或到达 deadline。不登记等待者，放弃时无需回滚。
+		 */
+		template <typename TryLock, typename Clock, typename Duration>
+		inline bool poll_lock_until(TryLock try_lock, const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+			u32 spins = 1;
+			while (!try_lock()) {
+				if (Clock::now() >= deadline) {
+					return false;
+				}
+				if (spins <= 1024) {
+					for (u32 i = 0; i < spins; i++) {
+						cpu::relax();
+					}
+					spins *= 2;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+			return true;
+		}
+	} // namespace detail
+
+	/**
+	 * @brief 按竞争时长升级的自适应自旋锁
+	 * flag_: 0 空闲 | 1 已加锁 | 2 已加锁且可能有挂起者（与 lock::futex_mutex 相同的三态协议）
+	 * 竞争路径按"这把锁已经连续被竞争了多久"决定怎么等，而不是按每个线程自己的自旋次数：
+	 * - contention_ 记录当前竞争者数和本轮竞争开始的 cycle_clock 读数，第一个竞争者写入时间戳，
+	 *   之后到达的线程沿用它，在已经长时间竞争的锁上直接跳过自旋
+	 * - 已竞争时长 < 阈值：cpu::relax 指数退避自旋
+	 * - 阈值 ~ 2 倍阈值：std::this_thread::yield
+	 * - 超过 2 倍阈值：把 flag_ 置为 2 后 futex 挂起，解锁方看到 2 才发起唤醒
+	 * 每个线程的阶段只升不降，时间戳只保留低 32 位，回绕不会让挂起过的线程重新自旋。
+	 * 阈值：每把锁可用 get_and_set_wait_start_time 单独设置，为 0 时使用进程级的
+	 * get_and_set_global_wait_start_time（默认 10us）。
+	 */
 	class spin_lock {
 	private:
-		struct alignas(8) state_t {
-			u32 wait_start_; // 等待开始时间
-			u16 wait_count_; // 等待数
-			u8 lock_;		 // 锁状态
-		};
+		inline static constexpr u32 unlocked = 0;
+		inline static constexpr u32 locked = 1;
+		inline static constexpr u32 contended = 2;
 
-	public:
-		inline bool is_locked() const noexcept {
-			return (std::bit_cast<state_t>(flag_.load(std::memory_order_relaxed)).lock_ != 0);
-		}
+		// contention_ 的位分配: [0,32) 竞争者数 [32,64) 本轮竞争开始时间（cycle_clock 低 32 位）
+		inline static constexpr u64 contender_mask = 0xFFFF'FFFF;
 
-		inline bool try_lock() noexcept {
-			// 1. 先用 relaxed load 过滤，避免频繁触发昂贵的 CAS
-			u64 old_val = flag_.load(std::memory_order_relaxed);
-			if (std::bit_cast<state_t>(old_val).lock_ != 0)
-				return false;
+	public:
+		spin_lock() noexcept = default;
+		spin_lock(const spin_lock &) = delete;
+		spin_lock &operator=(const spin_lock &) = delete;
 
-			state_t new_val = std::bit_cast<state_t>(old_val);
-			new_val.lock_ = 1;
+		inline bool is_locked() const noexcept { return flag_.load(std::memory_order_relaxed) != unlocked; }
 
-			// 2. CAS 成功用 acquire，失败用 relaxed
-			return flag_.compare_exchange_weak(old_val, std::bit_cast<u64>(new_val),
-											   std::memory_order_acquire,
-											   std::memory_order_relaxed);
+		[[nodiscard]] inline bool try_lock() noexcept {
+			// 先用 relaxed load 过滤，避免在已加锁时触发 CAS
+			u32 expected = unlocked;
+			return flag_.load(std::memory_order_relaxed) == unlocked &&
+				   flag_.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
 		}
 
 		inline void lock() noexcept {
 			if (try_lock()) [[likely]]
 				return;
+			lock_contended<false>({});
+		}
 
-			u64 now_sleep_ns = 1000;
-			// 标记当前线程是否已经增加了 wait_count_
-			bool has_incremented_wait = false;
-
-			while (true) {
-				u64 old_val = flag_.load(std::memory_order_relaxed);
-				state_t new_val = std::bit_cast<state_t>(old_val);
-
-				// 尝试抢锁
-				if (new_val.lock_ == 0) {
-					state_t new_state = new_val;
-					new_state.lock_ = 1;
-					// 如果抢锁成功，且之前增加过计数，记得减回去
-					if (has_incremented_wait) {
-						if (new_state.wait_count_ > 0)
-							new_state.wait_count_--;
-					}
-					if (flag_.compare_exchange_weak(old_val, std::bit_cast<u64>(new_state),
-													std::memory_order_acquire,
-													std::memory_order_relaxed))
-						return;
-					continue;
-				}
+		template <typename Rep, typename Period>
+		[[nodiscard]] inline bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+			return try_lock() || lock_contended<true>(thread::futex_deadline_after(timeout));
+		}
 
-				// --- 慢速路径 ---
-				u64 wait_ns = get_and_set_wait_start_time();
-				if (now_sleep_ns >= wait_ns) {
-					// 只有还没增加过计数时才增加
-					if (!has_incremented_wait) {
-						while (true) {
-							old_val = flag_.load(std::memory_order_relaxed);
-							state_t next_s = std::bit_cast<state_t>(old_val);
-							next_s.wait_count_++;
-							if (flag_.compare_exchange_weak(old_val, std::bit_cast<u64>(next_s),
-															std::memory_order_relaxed)) {
-								has_incremented_wait = true;
-								break;
-							}
-						}
-					}
-					// 此时 old_val 包含了最新的计数状态
-					flag_.wait(old_val, std::memory_order_relaxed);
-				} else {
-					// 退避逻辑...
-					cpu::cpu_relax();
-				}
-			}
+		// 限时加锁：与 lock() 相同的升级过程，挂起阶段使用带截止时间的 futex 等待
+		template <typename Clock, typename Duration>
+		[[nodiscard]] inline bool try_lock_until(const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+			return try_lock() || lock_contended<true>(thread::to_futex_deadline(deadline));
 		}
 
 		inline void unlock() noexcept {
-			u64 old_val = flag_.fetch_and(std::bit_cast<u64>(
-											  state_t{.wait_start_ = u32(-1), .wait_count_ = u16(-1), .lock_ = 0}),
-										  std::memory_order_release);
-
-			if (std::bit_cast<state_t>(old_val).wait_count_ > 0) {
-				flag_.notify_one();
+			if (flag_.exchange(unlocked, std::memory_order_release) == contended) [[unlikely]] {
+				thread::futex_wake_one(flag_);
 			}
 		}
 
 		/**
-		 * @brief 获取全局wait开始时间
+		 * @brief 获取全局wait开始时间（竞争多久后放弃自旋），对所有未单独设置的 spin_lock 生效
 		 * @param ns 0 表示不设置, 仅读取
 		 */
-		inline u64 get_and_set_global_wait_start_time(u64 ns = 0) noexcept {
-			static std::atomic<u64> global_wait_start_time_{10'000};
-			if (ns == 0) {
-				return global_wait_start_time_.load();
-			} else {
-				global_wait_start_time_.store(ns);
-				return global_wait_start_time_.load();
+		inline static u64 get_and_set_global_wait_start_time(u64 ns = 0) noexcept {
+			if (ns != 0) {
+				global_wait_start_time_.store(ns, std::memory_order_relaxed);
 			}
+			return global_wait_start_time_.load(std::memory_order_relaxed);
 		}
 
 		/**
-		 * @brief 获取wait开始时间
-		 * @param ns 0 表示不设置, 仅读取
+		 * @brief 获取本锁的wait开始时间，未单独设置时返回全局值
+		 * @param ns 0 表示不设置, 仅读取；超过 u32 的值截断为 u32 最大值
 		 */
 		inline u64 get_and_set_wait_start_time(u64 ns = 0) noexcept {
-			if (ns == 0) {
-				u64 tmp = flag_.load(std::memory_order_acquire);
-				if (tmp == 0) {
-					return get_and_set_global_wait_start_time();
-				}
-				return tmp;
-			} else {
-				flag_.fetch_and(std::bit_cast<u64>(state_t{.wait_start_ = 0, .wait_count_ = u16(-1), .lock_ = u8(-1)}));
-				flag_.fetch_or(std::bit_cast<u64>(state_t{.wait_start_ = static_cast<u32>(ns), .wait_count_ = 0, .lock_ = 0}));
-				return flag_.load();
+			if (ns != 0) {
+				wait_start_.store(u32(std::min<u64>(ns, u32(-1))), std::memory_order_relaxed);
 			}
+			u32 tmp = wait_start_.load(std::memory_order_relaxed);
+			return tmp != 0 ? tmp : get_and_set_global_wait_start_time();
 		}
 
 	private:
-		std::atomic<u64> flag_;
-	};
+		// 登记为竞争者，返回本轮竞争开始时间
+		inline u32 enter_contention(u64 now) noexcept {
+			u64 c = contention_.load(std::memory_order_relaxed);
+			u64 next;
+			do {
+				next = (c & contender_mask) == 0 ? (u64(u32(now)) << 32) | 1 : c + 1;
+			} while (!contention_.compare_exchange_weak(c, next, std::memory_order_relaxed));
+			return u32(next >> 32);
+		}
+
+		inline void leave_contention() noexcept { contention_.fetch_sub(1, std::memory_order_relaxed); }
+
+		/**
+		 * @brief 竞争路径
+		 * @return 是否获取成功（不限时总是 true）
+		 */
+		template <bool timed>
+		CHENC_NO_INLINE bool lock_contended(thread::futex_clock::time_point deadline) noexcept {
+			const cpu::cycle_clock &clock = cpu::cycle_clock::get();
+			const u32 threshold = u32(std::min<u64>(clock.from_ns(get_and_set_wait_start_time()), u32(-1) / 2));
+			const u32 start = enter_contention(clock.now());
+
+			enum class stage { spin, yield, park } st = stage::spin;
+			u32 spins = 1;
+			bool acquired = true;
+			while (true) {
+				if (st != stage::park) {
+					u32 expected = unlocked;
+					if (flag_.load(std::memory_order_relaxed) == unlocked &&
+						flag_.compare_exchange_strong(expected, locked, std::memory_order_acquire,
+													  std::memory_order_relaxed)) {
+						break;
+					}
+					u32 elapsed = u32(clock.now()) - start;
+					if (elapsed >= 2 * threshold) {
+						st = stage::park;
+					} else if (elapsed >= threshold) {
+						st = stage::yield;
+					}
+				}
+				if constexpr (timed) {
+					if (thread::futex_clock::now() >= deadline) {
+						acquired = false;
+						break;
+					}
+				}
+				if (st == stage::spin) {
+					for (u32 i = 0; i < spins; i++) {
+						cpu::relax();
+					}
+					spins = std::min<u32>(spins * 2, 64);
+				} else if (st == stage::yield) {
+					std::this_thread::yield();
+				} else {
+					// 挂起后获取时保留 2：可能还有其他挂起者，解锁方需要唤醒它们
+					if (flag_.exchange(contended, std::memory_order_acquire) == unlocked) {
+						break;
+					}
+					if constexpr (timed) {
+						if (!thread::futex_wait_until(flag_, contended, deadline)) {
+							acquired = flag_.exchange(contended, std::memory_order_acquire) == unlocked;
+							break;
+						}
+					} else {
+						thread::futex_wait(flag_, contended);
+					}
+				}
+			}
+			leave_contention();
+			return acquired;
+		}
 
-	bool try_lock(spin_lock &l) noexcept {
-		return l.try_lock();
-	}
-	void lock(spin_lock &l) noexcept { l.lock(); }
-	void unlock(spin_lock &l) noexcept { l.unlock(); }
+		inline static std::atomic<u64> global_wait_start_time_{10'000};
+
+		std::atomic<u32> flag_{unlocked};
+		std::atomic<u32> wait_start_{0}; // 本锁的wait开始时间（ns），0 表示使用全局值
+		std::atomic<u64> contention_{0};
+	};
 
 	class rw_lock {
 		/**
@@ -263,13 +322,24 @@ namespace chenc {
 						auto start = std::chrono::steady_clock::now();
 						// 使用 chrono 高精度计时, 哪怕开销较大
 						while (std::chrono::steady_clock::now() - start < std::chrono::nanoseconds(now_sleep_ns)) {
-							cpu::cpu_relax();
+							cpu::relax();
 						}
 						now_sleep_ns *= 2;
 					}
 				}
 			}
 
+			template <typename Rep, typename Period>
+			inline bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+				return try_lock_until(std::chrono::steady_clock::now() + timeout);
+			}
+
+			// 限时加锁（轮询，见 detail::poll_lock_until）
+			template <typename Clock, typename Duration>
+			inline bool try_lock_until(const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+				return detail::poll_lock_until([this]() noexcept { return try_lock(); }, deadline);
+			}
+
 			inline void unlock() noexcept {
 				auto expected = parent.state_.load(std::memory_order_acquire);
 				while (true) {
@@ -398,13 +468,24 @@ namespace chenc {
 						auto start = std::chrono::steady_clock::now();
 						// 使用 chrono 高精度计时, 哪怕开销较大
 						while (std::chrono::steady_clock::now() - start < std::chrono::nanoseconds(now_sleep_ns)) {
-							cpu::cpu_relax();
+							cpu::relax();
 						}
 						now_sleep_ns *= 2;
 					}
 				}
 			}
 
+			template <typename Rep, typename Period>
+			inline bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout) noexcept {
+				return try_lock_until(std::chrono::steady_clock::now() + timeout);
+			}
+
+			// 限时加锁（轮询，见 detail::poll_lock_until）
+			template <typename Clock, typename Duration>
+			inline bool try_lock_until(const std::chrono::time_point<Clock, Duration> &deadline) noexcept {
+				return detail::poll_lock_until([this]() noexcept { return try_lock(); }, deadline);
+			}
+
 			inline void unlock() noexcept {
 				auto expected = parent.state_.load(std::memory_order_acquire);
 				while (true) {
@@ -0,0 +1,359 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chenc::thread {
+	// 任务拆分策略
+	enum class partitioner : u8 {
+		simple, // 递归二分直到 grain
+		lazy	// 惰性二分：只有本地队列空（其他线程可能缺活）时才拆分
+	};
+
+	// 归约顺序
+	enum class reduce_order : u8 {
+		any,		  // 自适应拆分，合并顺序保持区间顺序，但拆分树随调度变化
+		deterministic // 固定按 grain 分块，按块序号依次合并，结果与线程数和调度无关
+	};
+
+	/**
+	 * @brief 缓存行感知的 grain
+	 * 将 grain 向上取整为一条缓存行所含 T 元素数的整数倍，
+	 * 使相邻任务写入的输出不落在同一缓存行上（输出起始地址对齐时）。
+	 */
+	template <typename T>
+	inline constexpr u64 cache_grain(u64 grain = 1) noexcept {
+		constexpr u64 per_line = sizeof(T) >= CHENC_CACHE_LINE ? 1 : CHENC_CACHE_LINE / sizeof(T);
+		grain = std::max<u64>(grain, 1);
+		return (grain + per_line - 1) / per_line * per_line;
+	}
+
+	namespace detail {
+		// 在线程池中执行 fn：本池 worker 直接调用，其他线程提交后等待
+		template <typename F>
+		inline void run_in_pool(thread_pool &pool, F &&fn) {
+			if (thread_pool::current() == &pool) {
+				fn();
+			} else {
+				pool.add_task([&fn]() { fn(); }).get();
+			}
+		}
+
+		// 并行执行上下文：记录第一个异常，并让后续分块尽快跳过
+		struct parallel_context {
+			thread_pool &pool_;
+			u64 grain_;
+			partitioner part_;
+			std::atomic<bool> failed_{false};
+			std::exception_ptr error_{};
+
+			inline void fail() noexcept { fail(std::current_exception()); }
+			inline void fail(std::exception_ptr e) noexcept {
+				bool expected = false;
+				if (failed_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+					error_ = std::move(e);
+				}
+			}
+			inline bool failed() const noexcept { return failed_.load(std::memory_order_relaxed); }
+			inline void rethrow() const {
+				if (failed_.load(std::memory_order_acquire)) {
+					std::rethrow_exception(error_);
+				}
+			}
+
+			// 按 grain 对齐的二分点；区间不足两个 grain 时返回 b
+			template <typename I>
+			inline I split_point(I b, I e) const noexcept {
+				u64 blocks = u64(e - b) / grain_;
+				return b + I((blocks / 2) * grain_);
+			}
+
+			/**
+			 * 处理 [b, e) 时最多拆分的次数：每次拆分至少把剩余块数减半，
+			 * 块数少于 2 时不再拆分，所以不超过 bit_width(块数)
+			 */
+			template <typename I>
+			inline u64 split_limit(I b, I e) const noexcept {
+				return u64(std::bit_width(u64(e - b) / grain_));
+			}
+
+			// 是否应该继续拆分
+			template <typename I>
+			inline bool should_split(I b, I e) const noexcept {
+				if (u64(e - b) < grain_ * 2) {
+					return false;
+				}
+				return part_ == partitioner::simple || pool_.local_task_count() == 0;
+			}
+		};
+
+		// 一个被拆出的子任务结果槽
+		template <typename T>
+		struct split_slot {
+			std::atomic<bool> done_{false};
+			bool filled_ = false; // 子任务产出了结果；失败或未执行时为 false
+			alignas(T) std::byte value_[sizeof(T)];
+
+			inline T *get_ptr() noexcept { return reinterpret_cast<T *>(value_); }
+		};
+
+		// 一次归约调用共享的参数；子任务只捕获它的引用，保证闭包能放进 task 的内联缓冲区
+		template <typename T, typename Map, typename Reduce>
+		struct reduce_job {
+			parallel_context &ctx_;
+			const T &identity_;
+			Map &map_;
+			Reduce &reduce_;
+		};
+
+		/**
+		 * @brief 子任务对结果槽的凭据
+		 * 子任务未执行就被销毁（提交抛出、被 stop(false) 丢弃）时记录失败并结束该槽，
+		 * 等待它的父区间不会永远阻塞
+		 */
+		template <typename T, typename Job>
+		class split_ticket {
+		public:
+			split_ticket(Job &job, split_slot<T> *slot) noexcept
+				: job_(&job), slot_(slot) {}
+			split_ticket(split_ticket &&other) noexcept
+				: job_(other.job_), slot_(std::exchange(other.slot_, nullptr)) {}
+			split_ticket &operator=(split_ticket &&) = delete;
+
+			~split_ticket() {
+				if (slot_ != nullptr) {
+					job_->ctx_.fail(std::make_exception_ptr(std::runtime_error("parallel: subrange dropped by thread_pool")));
+					slot_->done_.store(true, std::memory_order_release);
+				}
+			}
+
+			inline Job &job() const noexcept { return *job_; }
+			inline split_slot<T> *release() noexcept { return std::exchange(slot_, nullptr); }
+
+		private:
+			Job *job_;
+			split_slot<T> *slot_;
+		};
+
+		/**
+		 * @brief 区间归约核心：处理 [b, e)，返回该区间的归约结果
+		 * simple 模式下先拆到 grain 再处理；lazy 模式下逐块处理，每块前检查是否需要拆分。
+		 * 拆出的右半区间放入本地队列，结果按区间顺序合并。
+		 * 拆分失败（分配或提交抛出）时记录异常并停止处理，但仍等待已提交的子任务结束后才返回：
+		 * 子任务引用着本层的结果槽与上层的 job。
+		 */
+		template <typename I, typename T, typename Map, typename Reduce>
+		T reduce_range(reduce_job<T, Map, Reduce> &job, I b, I e) {
+			parallel_context &ctx = job.ctx_;
+			// 结果槽按本区间的拆分上限在第一次拆分时分配，不拆分的叶子区间不分配
+			std::unique_ptr<split_slot<T>[]> slots;
+			u64 spawned = 0;
+			T acc = job.identity_;
+
+			while (b < e && !ctx.failed()) {
+				if (ctx.should_split(b, e)) {
+					if (!slots) {
+						try {
+							slots.reset(new split_slot<T>[ctx.split_limit(b, e)]);
+						} catch (...) {
+							ctx.fail();
+							continue;
+						}
+					}
+					I mid = ctx.split_point(b, e);
+					// 提交失败时 task 在 catch 之后析构，由凭据结束槽位：先记录的是提交抛出的异常
+					auto task = [ticket = split_ticket<T, reduce_job<T, Map, Reduce>>(job, &slots[spawned]),
+								 mid, e]() mutable {
+						split_slot<T> *slot = ticket.release();
+						auto &job = ticket.job();
+						try {
+							new (slot->get_ptr()) T(reduce_range(job, mid, e));
+							slot->filled_ = true;
+						} catch (...) {
+							job.ctx_.fail();
+						}
+						slot->done_.store(true, std::memory_order_release);
+					};
+					try {
+						ctx.pool_.post(std::move(task));
+						spawned++;
+						e = mid;
+					} catch (...) {
+						ctx.fail();
+					}
+					continue;
+				}
+				I ce = (ctx.part_ == partitioner::simple || u64(e - b) <= ctx.grain_) ? e : I(b + I(ctx.grain_));
+				try {
+					acc = job.map_(b, ce, std::move(acc));
+				} catch (...) {
+					ctx.fail();
+				}
+				b = ce;
+			}
+
+			// 被拆出的区间越晚越靠左：逆序合并即为区间顺序
+			for (u64 i = spawned; i-- > 0;) {
+				split_slot<T> &slot = slots[i];
+				ctx.pool_.wait_until([&slot]() { return slot.done_.load(std::memory_order_acquire); });
+				if (!slot.filled_) {
+					continue;
+				}
+				T *v = slot.get_ptr();
+				if (!ctx.failed()) {
+					try {
+						acc = job.reduce_(std::move(acc), std::move(*v));
+					} catch (...) {
+						ctx.fail();
+					}
+				}
+				v->~T();
+			}
+			return acc;
+		}
+
+		// 在线程池中归约 [begin, end)
+		template <typename I, typename T, typename Map, typename Reduce>
+		T reduce_in_pool(thread_pool &pool, I begin, I end, u64 grain, partitioner part,
+						 const T &identity, Map &map, Reduce &reduce) {
+			parallel_context ctx{pool, std::max<u64>(grain, 1), part};
+			reduce_job<T, Map, Reduce> job{ctx, identity, map, reduce};
+			T result = identity;
+			run_in_pool(pool, [&]() {
+				result = reduce_range(job, begin, end);
+			});
+			ctx.rethrow();
+			return result;
+		}
+
+		struct empty_result {};
+	} // namespace detail
+
+	/**
+	 * @brief 并行 for
+	 * fn 可接受子区间 fn(b, e)，也可接受单个下标 fn(i)。
+	 * 在非本池线程调用时，调用线程阻塞直到全部完成；fn 抛出的第一个异常会被重新抛出。
+	 */
+	template <std::integral I, typename F>
+	void parallel_for(thread_pool &pool, I begin, I end, u64 grain, F &&fn,
+					  partitioner part = partitioner::lazy) {
+		if (begin >= end) {
+			return;
+		}
+		auto map = [&fn](I b, I e, detail::empty_result acc) {
+			if constexpr (std::is_invocable_v<F &, I, I>) {
+				fn(b, e);
+			} else {
+				for (I i = b; i < e; ++i) {
+					fn(i);
+				}
+			}
+			return acc;
+		};
+		auto reduce = [](detail::empty_result a, detail::empty_result) { return a; };
+		const detail::empty_result identity{};
+		detail::reduce_in_pool(pool, begin, end, grain, part, identity, map, reduce);
+	}
+
+	/**
+	 * @brief 并行归约
+	 * @param identity reduce 的单位元，每个子区间从它开始累积
+	 * @param map      map(b, e, acc) -> T：把 [b, e) 累积进 acc
+	 * @param reduce   reduce(lhs, rhs) -> T：合并相邻区间的结果，需满足结合律
+	 * @param order    deterministic 时分块固定为 grain，结果可复现（适用于浮点等非严格结合的运算）
+	 */
+	template <std::integral I, typename T, typename Map, typename Reduce>
+	T parallel_reduce(thread_pool &pool, I begin, I end, u64 grain, T identity, Map &&map, Reduce &&reduce,
+					  reduce_order order = reduce_order::any) {
+		if (begin >= end) {
+			return identity;
+		}
+		grain = std::max<u64>(grain, 1);
+
+		if (order == reduce_order::deterministic) {
+			u64 n = u64(end - begin);
+			u64 chunks = (n + grain - 1) / grain;
+			std::vector<T> partial(chunks, identity);
+			parallel_for(pool, u64(0), chunks, 1, [&](u64 c) {
+				I b = begin + I(c * grain);
+				I e = c + 1 == chunks ? end : I(b + I(grain));
+				partial[c] = map(b, e, std::move(partial[c]));
+			}, partitioner::simple);
+
+			T acc = std::move(identity);
+			for (auto &v : partial) {
+				acc = reduce(std::move(acc), std::move(v));
+			}
+			return acc;
+		}
+
+		return detail::reduce_in_pool(pool, begin, end, grain, partitioner::lazy, identity, map, reduce);
+	}
+
+	/**
+	 * @brief 并行包含式前缀扫描 out[i] = in[0] op ... op in[i]
+	 * 两遍分块：先并行求每块的归约，串行求块间前缀，再并行写出每块的扫描结果。
+	 * 分块大小按输出元素类型取缓存行整数倍。
+	 * @return 输出区间的尾后迭代器
+	 */
+	template <std::random_access_iterator InIt, std::random_access_iterator OutIt, typename Op = std::plus<>>
+	OutIt parallel_inclusive_scan(thread_pool &pool, InIt first, InIt last, OutIt out, u64 grain = 4096, Op op = {}) {
+		using T = std::iter_value_t<InIt>;
+		u64 n = u64(last - first);
+		if (n == 0) {
+			return out;
+		}
+		grain = cache_grain<std::iter_value_t<OutIt>>(grain);
+		u64 chunks = (n + grain - 1) / grain;
+		if (chunks == 1) {
+			return std::inclusive_scan(first, last, out, op);
+		}
+
+		// 1. 每块归约
+		std::vector<T> sums(chunks);
+		parallel_for(pool, u64(0), chunks, 1, [&](u64 c) {
+			InIt b = first + (c * grain);
+			InIt e = c + 1 == chunks ? last : b + grain;
+			T acc = *b;
+			for (++b; b != e; ++b) {
+				acc = op(std::move(acc), *b);
+			}
+			sums[c] = std::move(acc);
+		}, partitioner::simple);
+
+		// 2. 块间前缀（块数很少，串行）
+		for (u64 c = 1; c < chunks; ++c) {
+			sums[c] = op(sums[c - 1], sums[c]);
+		}
+
+		// 3. 每块带进位扫描
+		parallel_for(pool, u64(0), chunks, 1, [&](u64 c) {
+			InIt b = first + (c * grain);
+			InIt e = c + 1 == chunks ? last : b + grain;
+			OutIt o = out + (c * grain);
+			if (c == 0) {
+				std::inclusive_scan(b, e, o, op);
+			} else {
+				std::inclusive_scan(b, e, o, op, sums[c - 1]);
+			}
+		}, partitioner::simple);
+
+		return out + n;
+	}
+} // namespace chenc::thread
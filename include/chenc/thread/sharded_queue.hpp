@@ -0,0 +1,105 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/atomic_queue.hpp"
+#include "chenc/thread/thread_id.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace chenc::thread {
+	/**
+	 * @brief 分片多生产者多消费者队列
+	 * 每个分片是一个独立的 atomic_queue，线程通过 this_id() 绑定到本地分片：
+	 * 生产者只写本地分片，消费者先取本地分片，为空时再轮询窃取其余分片。
+	 * 只保证同一分片内的 FIFO，不保证全局 FIFO。
+	 */
+	template <typename T, queue_layout Layout = queue_layout::padded>
+	class sharded_queue {
+	public:
+		using queue_type = atomic_queue<T, Layout>;
+
+		/**
+		 * @param shard_count 分片数，0 表示按硬件线程数分片
+		 * @param shard_capa 每个分片的初始容量
+		 */
+		explicit sharded_queue(u64 shard_count = 0, u64 shard_capa = 1024) {
+			if (shard_count == 0) {
+				shard_count = std::max<u64>(1, std::thread::hardware_concurrency());
+			}
+			shards_.reserve(shard_count);
+			for (u64 i = 0; i < shard_count; ++i) {
+				shards_.emplace_back(std::make_unique<shard>(shard_capa));
+			}
+		}
+
+		sharded_queue(const sharded_queue &) = delete;
+		sharded_queue &operator=(const sharded_queue &) = delete;
+
+		// --- 入队：写入当前线程的本地分片 ---
+		inline void push(T &&value) {
+			push_to(local_index(), std::move(value));
+		}
+
+		// --- 入队：写入指定分片（用于按 NUMA 节点等外部规则分派） ---
+		inline void push_to(u64 shard_id, T &&value) {
+			shard &s = *shards_[shard_id % shards_.size()];
+			s.queue_.push(std::move(value));
+		}
+
+		// --- 出队：先取本地分片，再从下一个分片开始轮询窃取 ---
+		inline std::optional<T> pop() {
+			u64 n = shards_.size();
+			u64 local = local_index();
+			if (auto res = shards_[local]->queue_.pop()) [[likely]] {
+				return res;
+			}
+			for (u64 i = 1; i < n; ++i) {
+				shard &victim = *shards_[(local + i) % n];
+				// 先用近似 size 过滤空分片，避免在空队列上反复执行出队流程
+				if (victim.queue_.size() == 0) {
+					continue;
+				}
+				if (auto res = victim.queue_.pop()) {
+					return res;
+				}
+			}
+			return std::nullopt;
+		}
+
+		// --- 只从本地分片出队，不窃取 ---
+		inline std::optional<T> pop_local() {
+			return shards_[local_index()]->queue_.pop();
+		}
+
+		// 所有分片元素数之和（非严格一致）
+		u64 size() const noexcept {
+			u64 total = 0;
+			for (auto &s : shards_) {
+				total += s->queue_.size();
+			}
+			return total;
+		}
+
+		u64 shard_count() const noexcept { return shards_.size(); }
+
+		// 当前线程绑定的分片
+		inline u64 local_index() const noexcept {
+			return this_id() % shards_.size();
+		}
+
+	private:
+		// 分片单独分配并按缓存行对齐，避免相邻分片的 head/tail 互相干扰
+		struct alignas(CHENC_CACHE_LINE) shard {
+			explicit shard(u64 capa)
+				: queue_(capa) {}
+			queue_type queue_;
+		};
+
+		std::vector<std::unique_ptr<shard>> shards_;
+	};
+} // namespace chenc::thread
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/future.hpp"
+#include "chenc/thread/thread_pool.hpp"
+#include "chenc/thread/unique_function.hpp"
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace chenc::thread {
+	/**
+	 * @brief 任务依赖图（DAG）执行器
+	 * - 每个节点带原子依赖计数，前驱全部完成后才就绪
+	 * - 节点完成时，就绪的后继由完成它的 worker 直接执行一个、其余压入本地队列，保持续延局部性
+	 * - 根节点经线程池提交：外部线程调用时进入全局注入队列（atomic_queue）
+	 * - 图可重复运行，运行期间只为完成通知分配一个 future 共享状态（来自缓存块空闲链表）；同一张图不能并发运行
+	 * - 节点提交失败（线程池已停止、分配失败）或已提交的节点被 stop(false) 丢弃时，按节点抛出异常处理：
+	 *   该节点及其后继在当前线程上跳过并推进依赖，run() 等全部节点退役后重新抛出
+	 */
+	class task_graph {
+	private:
+		struct node {
+			unique_function<void()> func_;
+			std::vector<node *> successors_;
+			u32 dep_count_ = 0; // 前驱数（静态）
+			task_graph *graph_ = nullptr;
+			CHENC_CACHE_ALIGN std::atomic<u32> pending_{0}; // 本次运行尚未完成的前驱数
+		};
+
+		/**
+		 * @brief 提交给线程池的节点凭据
+		 * 任务执行时取出节点；任务未执行就被销毁（提交抛出、被 stop(false) 丢弃）时由析构退役节点，
+		 * 否则该节点的后继永远不会被计数，run() 永远等不到完成
+		 */
+		class node_ticket {
+		public:
+			explicit node_ticket(node *n) noexcept
+				: n_(n) {}
+			node_ticket(node_ticket &&other) noexcept
+				: n_(std::exchange(other.n_, nullptr)) {}
+			node_ticket &operator=(node_ticket &&) = delete;
+
+			~node_ticket() {
+				if (n_ != nullptr) {
+					n_->graph_->abandon(n_);
+				}
+			}
+
+			inline node *release() noexcept { return std::exchange(n_, nullptr); }
+
+		private:
+			node *n_;
+		};
+
+	public:
+		// 节点句柄
+		class node_ref {
+		public:
+			node_ref() noexcept = default;
+
+			// 本节点先于 others 执行
+			template <typename... Refs>
+			inline node_ref &precede(Refs... others) {
+				(link(ptr_, others.ptr_), ...);
+				return *this;
+			}
+
+			// 本节点在 others 之后执行
+			template <typename... Refs>
+			inline node_ref &succeed(Refs... others) {
+				(link(others.ptr_, ptr_), ...);
+				return *this;
+			}
+
+			inline bool valid() const noexcept { return ptr_ != nullptr; }
+
+		private:
+			friend class task_graph;
+			explicit node_ref(node *p) noexcept
+				: ptr_(p) {}
+
+			inline static void link(node *from, node *to) {
+				from->successors_.push_back(to);
+				to->dep_count_++;
+				from->graph_->dirty_ = true;
+			}
+
+			node *ptr_ = nullptr;
+		};
+
+	public:
+		task_graph() = default;
+		task_graph(const task_graph &) = delete;
+		task_graph &operator=(const task_graph &) = delete;
+
+		// 添加节点
+		template <typename F>
+		inline node_ref emplace(F &&f) {
+			node &n = nodes_.emplace_back();
+			n.func_ = unique_function<void()>(std::forward<F>(f));
+			n.graph_ = this;
+			dirty_ = true;
+			return node_ref(&n);
+		}
+
+		// 批量添加节点
+		template <typename... Fs>
+			requires(sizeof...(Fs) > 1)
+		inline auto emplace(Fs &&...fs) {
+			return std::make_tuple(emplace(std::forward<Fs>(fs))...);
+		}
+
+		u64 size() const noexcept { return nodes_.size(); }
+		bool empty() const noexcept { return nodes_.empty(); }
+
+		void clear() {
+			nodes_.clear();
+			roots_.clear();
+			dirty_ = false;
+		}
+
+		/**
+		 * @brief 在线程池上运行整张图并等待完成
+		 * 某个节点抛出异常后，尚未开始的节点被跳过（依赖关系仍然推进），异常在此重新抛出。
+		 * 图中存在环时抛出 std::logic_error。
+		 */
+		void run(thread_pool &pool) {
+			if (nodes_.empty()) {
+				return;
+			}
+			prepare();
+
+			pool_ = &pool;
+			for (auto &n : nodes_) {
+				n.pending_.store(n.dep_count_, std::memory_order_relaxed);
+			}
+			remaining_.store(nodes_.size(), std::memory_order_relaxed);
+			failed_.store(false, std::memory_order_relaxed);
+			error_ = nullptr;
+
+			// 完成通知走引用计数的共享状态：等待方看到完成后可以立即销毁图，
+			// 最后完成的 worker 之后的唤醒与释放只触及共享状态
+			promise<void> done;
+			future<void> finished = done.get_future();
+			done_ = std::move(done);
+
+			// 某个根提交失败时已提交的根照常运行，下面统一等待全部节点退役
+			for (node *r : roots_) {
+				post_node(r);
+			}
+
+			if (thread_pool::current() == &pool) {
+				pool.wait_until([&finished]() { return finished.ready(); });
+			}
+			finished.get();
+		}
+
+	private:
+		// 结构变化后重新计算根节点，并用 Kahn 算法检查是否有环
+		void prepare() {
+			if (!dirty_) {
+				return;
+			}
+			roots_.clear();
+			std::vector<node *> order;
+			order.reserve(nodes_.size());
+			for (auto &n : nodes_) {
+				n.pending_.store(n.dep_count_, std::memory_order_relaxed);
+				if (n.dep_count_ == 0) {
+					roots_.push_back(&n);
+					order.push_back(&n);
+				}
+			}
+			for (u64 i = 0; i < order.size(); ++i) {
+				for (node *s : order[i]->successors_) {
+					if (s->pending_.fetch_sub(1, std::memory_order_relaxed) == 1) {
+						order.push_back(s);
+					}
+				}
+			}
+			if (order.size() != nodes_.size()) {
+				throw std::logic_error("task_graph: graph contains a cycle");
+			}
+			dirty_ = false;
+		}
+
+		// 记录第一个异常；之后尚未开始的节点都被跳过
+		void fail(std::exception_ptr e) noexcept {
+			bool expected = false;
+			if (failed_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+				error_ = std::move(e);
+			}
+		}
+
+		/**
+		 * @brief 把就绪节点交给线程池
+		 * 提交抛出时记录该异常；未交出的凭据在返回前析构，在本线程退役节点
+		 */
+		void post_node(node *n) noexcept {
+			auto task = [ticket = node_ticket(n)]() mutable {
+				node *n = ticket.release();
+				n->graph_->execute(n);
+			};
+			try {
+				pool_->post(std::move(task));
+			} catch (...) {
+				fail(std::current_exception());
+			}
+		}
+
+		// 节点没有被线程池执行：标记失败后就地推进依赖（失败后节点函数都被跳过）
+		void abandon(node *n) noexcept {
+			fail(std::make_exception_ptr(std::runtime_error("task_graph: node dropped by thread_pool")));
+			execute(n);
+		}
+
+		// 执行一个节点，并沿就绪后继继续执行
+		void execute(node *n) noexcept {
+			while (n != nullptr) {
+				if (!failed_.load(std::memory_order_relaxed)) {
+					try {
+						n->func_();
+					} catch (...) {
+						fail(std::current_exception());
+					}
+				}
+
+				// 第一个就绪后继留在本线程继续执行，其余压入本地队列
+				node *next = nullptr;
+				for (node *s : n->successors_) {
+					if (s->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+						if (next == nullptr) {
+							next = s;
+						} else {
+							post_node(s);
+						}
+					}
+				}
+
+				if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					// 先把 promise 移出图再发布：发布之后图可能已被等待方销毁
+					promise<void> done = std::move(done_);
+					if (failed_.load(std::memory_order_relaxed)) {
+						done.set_exception(error_);
+					} else {
+						done.set_value();
+					}
+				}
+				n = next;
+			}
+		}
+
+	private:
+		std::deque<node> nodes_; // deque 追加时不移动已有元素，node 地址稳定
+		std::vector<node *> roots_;
+		bool dirty_ = false;
+
+		thread_pool *pool_ = nullptr;
+		std::exception_ptr error_{};
+		CHENC_CACHE_ALIGN std::atomic<u64> remaining_{0};
+		promise<void> done_; // 本次运行的完成通知，由最后完成的节点移出并发布
+		std::atomic<bool> failed_{false};
+	};
+} // namespace chenc::thread
@@ -1,207 +1,834 @@
-// #pragma once
-
-// #include "chenc/atomic_list.hpp"
-// #include "chenc/type_int.hpp"
-
-// #include <atomic>
-// #include <chrono>
-// #include <functional>
-// #include <future>
-// #include <stdexcept>
-// #include <thread>
-// #include <vector>
-
-// namespace chenc {
-
-// 	class thread_pool {
-// 	public:
-// 		// ============================
-// 		// 线程池状态定义
-// 		// ============================
-// 		enum class type {
-// 			init,
-// 			pause, // 阻塞 add_task；worker drain 队列
-// 			run,
-// 			stop,	   // 不接新任务，执行完队列后退出
-// 			force_stop // 立即退出
-// 		};
-
-// 	public:
-// 		// ============================
-// 		// 构造 / 析构
-// 		// ============================
-// 		explicit thread_pool(
-// 			u64 thread_num = std::thread::hardware_concurrency(),
-// 			u64 task_capacity = 1024)
-// 			: tasks_(task_capacity), flag_(type::init), threads_count_(0) {
-// 			if (thread_num == 0) {
-// 				throw std::invalid_argument("thread_pool: thread_num must >= 1");
-// 			}
-
-// 			threads_.reserve(thread_num);
-// 			for (u64 i = 0; i < thread_num; ++i) {
-// 				threads_.emplace_back(
-// 					std::jthread(&thread_pool::worker_loop, this));
-// 			}
-
-// 			flag_.store(type::run, std::memory_order_release);
-// 		}
-
-// 		~thread_pool() {
-// 			flag_.store(type::force_stop, std::memory_order_release);
-// 			wake_all_workers();
-
-// 			// 等待所有 worker 退出
-// 			while (threads_count_.load(std::memory_order_acquire) != 0) {
-// 				std::this_thread::sleep_for(std::chrono::milliseconds(1));
-// 			}
-// 		}
-
-// 		// ============================
-// 		// 提交任务（阻塞 / future）
-// 		// ============================
-// 		template <class F, class... Args>
-// 		auto add_task(F &&f, Args &&...args)
-// 			-> std::future<std::invoke_result_t<F, Args...>> {
-// 			using R = std::invoke_result_t<F, Args...>;
-
-// 			// 1. 等待进入 run 状态
-// 			while (true) {
-// 				auto s = flag_.load(std::memory_order_acquire);
-
-// 				if (s == type::run)
-// 					break;
-
-// 				// pause：阻塞提交
-// 				if (s == type::pause) {
-// 					submit_gate_.wait(true, std::memory_order_acquire);
-// 					continue;
-// 				}
-
-// 				// stop / force_stop
-// 				throw std::runtime_error("thread_pool stopped");
-// 			}
-
-// 			// 2. 包装任务
-// 			auto task = std::make_shared<std::packaged_task<R()>>(
-// 				std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-
-// 			std::future<R> fut = task->get_future();
-
-// 			// 3. 推入任务队列
-// 			if (!tasks_.push([task]() { (*task)(); })) {
-// 				throw std::runtime_error("thread_pool task queue full");
-// 			}
-
-// 			// 4. 唤醒 worker
-// 			wake_one_worker();
-
-// 			return fut;
-// 		}
-
-// 		// ============================
-// 		// 状态控制
-// 		// ============================
-
-// 		// 阻塞 add_task，但 worker 继续 drain 队列
-// 		void pause() {
-// 			submit_gate_.test_and_set(std::memory_order_release);
-// 			flag_.store(type::pause, std::memory_order_release);
-// 		}
-
-// 		// 允许继续 add_task
-// 		void resume() {
-// 			flag_.store(type::run, std::memory_order_release);
-// 			submit_gate_.clear(std::memory_order_release);
-// 			submit_gate_.notify_all();
-
-// 			wake_all_workers();
-// 		}
-
-// 		// 停止线程池
-// 		void stop(bool wait_for_task_done = true) {
-// 			flag_.store(
-// 				wait_for_task_done ? type::stop : type::force_stop,
-// 				std::memory_order_release);
-
-// 			submit_gate_.clear(std::memory_order_release);
-// 			submit_gate_.notify_all();
-// 			wake_all_workers();
-
-// 			while (threads_count_.load(std::memory_order_acquire) != 0) {
-// 				std::this_thread::sleep_for(std::chrono::milliseconds(1));
-// 			}
-// 		}
-
-// 		// 当前任务数（非严格一致）
-// 		u64 task_count() const {
-// 			return tasks_.size();
-// 		}
-
-// 	private:
-// 		// ============================
-// 		// worker 主循环
-// 		// ============================
-// 		void worker_loop() {
-// 			threads_count_.fetch_add(1, std::memory_order_relaxed);
-
-// 			// RAII 退出计数
-// 			auto on_exit = std::unique_ptr<void, decltype([&](void *) {
-// 											   threads_count_.fetch_sub(1, std::memory_order_relaxed);
-// 										   })>(nullptr);
-
-// 			while (true) {
-// 				auto s = flag_.load(std::memory_order_acquire);
-
-// 				// 强制停止：立即退出
-// 				if (s == type::force_stop) {
-// 					return;
-// 				}
-
-// 				// 尝试取任务
-// 				if (auto task = tasks_.pop()) {
-// 					task.value()();
-// 					continue;
-// 				}
-
-// 				// 队列为空
-// 				if (s == type::stop) {
-// 					// stop：drain 完后退出
-// 					return;
-// 				}
-
-// 				// run / pause：进入等待区
-// 				worker_gate_.wait(true, std::memory_order_acquire);
-// 			}
-// 		}
-
-// 		// ============================
-// 		// worker 唤醒工具
-// 		// ============================
-// 		void wake_one_worker() {
-// 			worker_gate_.clear(std::memory_order_release);
-// 			worker_gate_.notify_one();
-// 			worker_gate_.test_and_set(std::memory_order_release);
-// 		}
-
-// 		void wake_all_workers() {
-// 			worker_gate_.clear(std::memory_order_release);
-// 			worker_gate_.notify_all();
-// 			worker_gate_.test_and_set(std::memory_order_release);
-// 		}
-
-// 	private:
-// 		// ============================
-// 		// 成员变量
-// 		// ============================
-// 		std::vector<std::jthread> threads_;		   // worker 线程
-// 		atomic_list<std::function<void()>> tasks_; // 无锁任务队列
-
-// 		std::atomic<type> flag_;		 // 状态机
-// 		std::atomic<u64> threads_count_; // 活跃 worker 数
-
-// 		std::atomic_flag submit_gate_ = ATOMIC_FLAG_INIT; // add_task 阻塞门
-// 		std::atomic_flag worker_gate_ = ATOMIC_FLAG_INIT; // worker 等待门
-// 	};
-
-// } // namespace chenc
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/cpu/relax.hpp"
+#include "chenc/core/cpu/topology.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/atomic_queue.hpp"
+#include "chenc/thread/detail/block_cache.hpp"
+#include "chenc/thread/detail/work_deque.hpp"
+#include "chenc/thread/future.hpp"
+#include "chenc/thread/lock.hpp"
+#include "chenc/thread/thread_id.hpp"
+#include "chenc/thread/unique_function.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace chenc::thread {
+	// 线程池任务：加上所属缓存指针后，一个任务节点正好占一条缓存行
+	using task = unique_function<void(), CHENC_CACHE_LINE - 2 * sizeof(void *)>;
+
+	namespace detail {
+		struct task_node {
+			task func_;
+			block_cache *owner_ = nullptr;
+
+			// 从当前线程的块缓存分配节点
+			template <typename F>
+			inline static task_node *make(F &&f) {
+				block_cache &cache = block_cache::current();
+				task_node *node = new (cache.alloc()) task_node{task(std::forward<F>(f)), &cache};
+				return node;
+			}
+
+			inline static void destroy(task_node *node) noexcept {
+				block_cache *owner = node->owner_;
+				node->~task_node();
+				owner->free(node);
+			}
+		};
+		static_assert(sizeof(task_node) == block_cache::block_size);
+	} // namespace detail
+
+	// 任务优先级
+	enum class priority : u8 {
+		realtime = 0,	// 延迟敏感
+		normal = 1,		// 默认
+		background = 2, // 批处理
+	};
+	inline static constexpr u64 priority_count = 3;
+
+	// 优先级通道的选择策略
+	enum class lane_policy : u8 {
+		strict,	 // 总是先取高优先级通道
+		weighted // 按权重轮转首选通道，低优先级不会被饿死
+	};
+
+	// 线程池配置
+	struct pool_config {
+		u64 thread_num_ = std::thread::hardware_concurrency(); // worker 数
+		u64 task_capacity_ = 1024;							   // 注入队列初始容量
+		bool pin_threads_ = false;							   // 每个 worker 绑定到单个 CPU
+		bool numa_aware_ = false;							   // worker 按 NUMA 节点分组，绑定到所在节点并优先在节点内窃取
+		lane_policy lane_policy_ = lane_policy::strict;		   // 优先级通道选择策略
+		std::array<u32, priority_count> lane_weights_{8, 4, 1}; // weighted 策略下各通道的权重
+		std::function<void(std::exception_ptr)> exception_handler_{}; // post 提交的任务抛出的异常，见 thread_pool
+	};
+
+	namespace detail {
+		/**
+		 * @brief 一个优先级通道
+		 * 普通任务进入 FIFO（atomic_queue）；带截止时间的任务进入最小堆，
+		 * 通道内先按最早截止时间（EDF）取带截止时间的任务，再取 FIFO。
+		 */
+		struct alignas(CHENC_CACHE_LINE) task_lane {
+			struct deadline_entry {
+				i64 deadline_ns_;
+				u64 seq_; // 截止时间相同时保持提交顺序
+				task_node *task_;
+
+				inline bool operator>(const deadline_entry &other) const noexcept {
+					return deadline_ns_ != other.deadline_ns_ ? deadline_ns_ > other.deadline_ns_ : seq_ > other.seq_;
+				}
+			};
+
+			explicit task_lane(u64 capa)
+				: fifo_(capa) {}
+
+			inline void push(task_node *t) { fifo_.push(std::move(t)); }
+
+			/**
+			 * 接管 t：堆扩容抛出时销毁节点（连同其中的可调用对象）再向上抛出。
+			 * 在释放 heap_lock_ 之后销毁，可调用对象的析构可能再次提交任务
+			 */
+			inline void push(task_node *t, std::chrono::steady_clock::time_point deadline) {
+				i64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+				try {
+					std::scoped_lock guard(heap_lock_);
+					heap_.push_back({ns, heap_seq_++, t});
+					std::push_heap(heap_.begin(), heap_.end(), std::greater<>{});
+					heap_size_.store(heap_.size(), std::memory_order_release);
+				} catch (...) {
+					task_node::destroy(t);
+					throw;
+				}
+			}
+
+			inline task_node *pop() {
+				if (heap_size_.load(std::memory_order_acquire) != 0) {
+					std::scoped_lock guard(heap_lock_);
+					if (!heap_.empty()) {
+						std::pop_heap(heap_.begin(), heap_.end(), std::greater<>{});
+						task_node *t = heap_.back().task_;
+						heap_.pop_back();
+						heap_size_.store(heap_.size(), std::memory_order_release);
+						return t;
+					}
+				}
+				if (fifo_.size() != 0) {
+					if (auto t = fifo_.pop()) {
+						return *t;
+					}
+				}
+				return nullptr;
+			}
+
+			inline u64 size() const noexcept {
+				return fifo_.size() + heap_size_.load(std::memory_order_relaxed);
+			}
+
+			atomic_queue<task_node *> fifo_;
+			lock::mutex<> heap_lock_;
+			std::vector<deadline_entry> heap_; // 只在增长时分配
+			u64 heap_seq_ = 0;
+			CHENC_CACHE_ALIGN std::atomic<u64> heap_size_{0};
+		};
+	} // namespace detail
+
+	class timer_wheel;
+
+	/**
+	 * @brief 工作窃取线程池
+	 * - 每个 worker 拥有一个 Chase–Lev 双端队列，worker 内部提交的任务直接进入本地队列
+	 * - 外部线程提交的任务进入全局注入队列（atomic_queue）
+	 * - 本地队列为空时先取注入队列，再随机选择受害者窃取
+	 * - 空闲 worker 通过 std::atomic::wait 挂起，stop() 通过 join 确定性地等待退出
+	 * - 任务节点与 future 共享状态来自每个 worker 的块缓存，小任务提交/完成不调用 malloc
+	 * - 可选 CPU 绑定与 NUMA 分组：worker 按节点依次排布，窃取时先找同节点的受害者
+	 * - 三个优先级通道（realtime/normal/background），各自带 FIFO 与截止时间堆；
+	 *   normal 任务在 worker 内提交时进入本地队列，其余优先级总是进入通道
+	 * - 可安装一个空闲钩子（如 timer_wheel）：worker 空闲时轮询，其中一个 worker 按间隔小睡代替挂起
+	 * - 异常：add_task 的异常由 future 传回；post 提交的任务和空闲钩子没有结果通道，抛出的异常被捕获后
+	 *   交给 pool_config::exception_handler_（在执行该任务的线程上调用，处理器本身不能抛出），
+	 *   没有处理器时丢弃，只计入 unhandled_exception_count()
+	 */
+	class thread_pool {
+	public:
+		// ============================
+		// 线程池状态定义
+		// ============================
+		enum class type : u32 {
+			init,
+			pause, // 阻塞 add_task；worker drain 队列
+			run,
+			stop,	   // 不接新任务，执行完队列后退出
+			force_stop // 立即退出
+		};
+
+		inline static constexpr u64 npos = u64(-1);
+
+		/**
+		 * @brief 空闲钩子
+		 * worker 找不到任务时调用 poll_（忙碌时每 hook_poll_period_ 个任务也调用一次），返回 true 表示产生了新任务。
+		 * armed_ 返回 true 时，一个 worker 作为计时者每隔 interval_ 醒来轮询，而不是无限期挂起；
+		 * 因此计时者之外没有空闲 worker 时，新任务的延迟上限为 interval_。
+		 */
+		struct idle_hook {
+			void *ctx_ = nullptr;
+			bool (*poll_)(void *ctx) = nullptr;
+			bool (*armed_)(void *ctx) = nullptr;
+			std::chrono::nanoseconds interval_{0};
+		};
+
+	private:
+		using task_ptr = detail::task_node *;
+
+		struct alignas(CHENC_CACHE_LINE) worker {
+			detail::work_deque<task_ptr> deque_;
+			detail::block_cache *cache_ = nullptr; // 租借的块缓存
+			u64 rng_ = 0;						   // 窃取受害者选择的随机状态，仅本线程访问
+			u64 tick_ = 0;						   // weighted 通道策略的轮转计数，仅本线程访问
+			u64 since_poll_ = 0;				   // 距上次轮询空闲钩子执行的任务数，仅本线程访问
+			u64 node_ = 0;						   // 所在 NUMA 节点（topology::nodes() 下标）
+			std::vector<u32> affinity_;			   // 绑定的 CPU，空表示不绑定
+			std::vector<u64> near_;				   // 同节点的其他 worker
+			std::vector<u64> far_;				   // 其他节点的 worker
+		};
+
+		// 当前线程所属的线程池与 worker 序号
+		struct tls_info {
+			thread_pool *pool_ = nullptr;
+			u64 index_ = npos;
+		};
+		inline static tls_info &tls() noexcept {
+			static thread_local tls_info info;
+			return info;
+		}
+
+		// 空闲 worker 进入挂起前的自旋次数
+		inline static constexpr u64 idle_spin_count_ = 64;
+		// 忙碌 worker 每执行多少个任务轮询一次空闲钩子
+		inline static constexpr u64 hook_poll_period_ = 64;
+
+	public:
+		// ============================
+		// 构造 / 析构
+		// ============================
+		explicit thread_pool(
+			u64 thread_num = std::thread::hardware_concurrency(),
+			u64 task_capacity = 1024)
+			: thread_pool(pool_config{.thread_num_ = thread_num, .task_capacity_ = task_capacity}) {}
+
+		explicit thread_pool(const pool_config &config)
+			: lane_policy_(config.lane_policy_),
+			  exception_handler_(config.exception_handler_) {
+			u64 thread_num = config.thread_num_;
+			if (thread_num == 0) {
+				throw std::invalid_argument("thread_pool: thread_num must >= 1");
+			}
+			for (u64 i = 0; i < priority_count; ++i) {
+				lanes_[i] = std::make_unique<detail::task_lane>(config.task_capacity_);
+			}
+			build_lane_schedule(config.lane_weights_);
+
+			workers_.reserve(thread_num);
+			for (u64 i = 0; i < thread_num; ++i) {
+				workers_.emplace_back(std::make_unique<worker>());
+				workers_.back()->rng_ = 0x9E3779B97F4A7C15ull * (i + 1);
+				workers_.back()->cache_ = detail::block_cache::lease();
+			}
+			place_workers(config);
+			state_.store(type::run, std::memory_order_release);
+
+			threads_.reserve(thread_num);
+			for (u64 i = 0; i < thread_num; ++i) {
+				threads_.emplace_back(&thread_pool::worker_loop, this, i);
+			}
+		}
+
+		thread_pool(const thread_pool &) = delete;
+		thread_pool &operator=(const thread_pool &) = delete;
+
+		~thread_pool() {
+			stop(true);
+			for (auto &w : workers_) {
+				detail::block_cache::release(w->cache_);
+			}
+		}
+
+		// ============================
+		// 提交任务
+		// ============================
+
+		// 提交任务并返回 future
+		template <class F, class... Args>
+		auto add_task(F &&f, Args &&...args)
+			-> future<std::invoke_result_t<F, Args...>> {
+			using R = std::invoke_result_t<F, Args...>;
+
+			wait_for_submit();
+			promise<R> p;
+			future<R> fut = p.get_future();
+			schedule(detail::task_node::make(
+				[p = std::move(p), f = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable {
+					p.set_from(std::move(f), std::move(args)...);
+				}));
+			return fut;
+		}
+
+		// 按优先级提交任务并返回 future
+		template <class F, class... Args>
+		auto add_task_with(priority prio, F &&f, Args &&...args)
+			-> future<std::invoke_result_t<F, Args...>> {
+			using R = std::invoke_result_t<F, Args...>;
+
+			wait_for_submit();
+			promise<R> p;
+			future<R> fut = p.get_future();
+			schedule(detail::task_node::make(
+						 [p = std::move(p), f = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable {
+							 p.set_from(std::move(f), std::move(args)...);
+						 }),
+					 prio);
+			return fut;
+		}
+
+		// 提交任务，不关心结果
+		template <class F>
+		void post(F &&f) {
+			wait_for_submit();
+			schedule(detail::task_node::make(std::forward<F>(f)));
+		}
+
+		// 按优先级提交任务
+		template <class F>
+		void post(priority prio, F &&f) {
+			wait_for_submit();
+			schedule(detail::task_node::make(std::forward<F>(f)), prio);
+		}
+
+		/**
+		 * @brief 提交带截止时间的任务
+		 * 同一通道内，带截止时间的任务先于普通任务、并按截止时间从早到晚执行（EDF）。
+		 * 截止时间只影响顺序，过期任务依然会执行。
+		 */
+		template <class F>
+		void post(priority prio, std::chrono::steady_clock::time_point deadline, F &&f) {
+			wait_for_submit();
+			lanes_[u64(prio)]->push(detail::task_node::make(std::forward<F>(f)), deadline);
+			notify_one();
+		}
+
+		// ============================
+		// 状态控制
+		// ============================
+
+		// 阻塞 add_task，但 worker 继续 drain 队列
+		void pause() {
+			type expected = type::run;
+			state_.compare_exchange_strong(expected, type::pause, std::memory_order_acq_rel);
+		}
+
+		// 允许继续 add_task
+		void resume() {
+			type expected = type::pause;
+			if (state_.compare_exchange_strong(expected, type::run, std::memory_order_acq_rel)) {
+				state_.notify_all();
+			}
+		}
+
+		/**
+		 * @brief 停止线程池并 join 所有 worker
+		 * 不能在本池的 worker 中调用（worker 无法 join 自己），否则抛出 std::logic_error；
+		 * 析构函数同样会调用 stop，所以线程池也不能在自己的 worker 中销毁。
+		 * @param wait_for_task_done true: 执行完所有已提交的任务; false: 丢弃未开始的任务
+		 */
+		void stop(bool wait_for_task_done = true) {
+			if (tls().pool_ == this) {
+				throw std::logic_error("thread_pool: stop() called from one of its own workers");
+			}
+			type s = state_.load(std::memory_order_acquire);
+			while (s == type::init || s == type::pause || s == type::run) {
+				if (state_.compare_exchange_weak(s, wait_for_task_done ? type::stop : type::force_stop,
+												 std::memory_order_acq_rel)) {
+					break;
+				}
+			}
+			state_.notify_all();
+			wake_all();
+
+			for (auto &t : threads_) {
+				if (t.joinable()) {
+					t.join();
+				}
+			}
+
+			// worker 已全部退出：处理 stop 前后竞争提交、未被取走的任务
+			bool run_left = state_.load(std::memory_order_acquire) == type::stop;
+			for (auto &w : workers_) {
+				while (auto t = w->deque_.take()) {
+					finish(*t, run_left);
+				}
+			}
+			for (auto &l : lanes_) {
+				while (task_ptr t = l->pop()) {
+					finish(t, run_left);
+				}
+			}
+		}
+
+		// 当前状态
+		type state() const noexcept {
+			return state_.load(std::memory_order_acquire);
+		}
+
+		// 当前任务数（非严格一致）
+		u64 task_count() const noexcept {
+			u64 n = 0;
+			for (auto &l : lanes_) {
+				n += l->size();
+			}
+			for (auto &w : workers_) {
+				n += w->deque_.size();
+			}
+			return n;
+		}
+
+		u64 thread_count() const noexcept { return workers_.size(); }
+
+		// post 提交的任务与空闲钩子抛出的异常总数（含已交给 exception_handler_ 的）
+		u64 unhandled_exception_count() const noexcept {
+			return unhandled_exceptions_.load(std::memory_order_relaxed);
+		}
+
+		// worker 所在 NUMA 节点（cpu::topology::nodes() 下标）
+		u64 worker_node(u64 index) const noexcept { return workers_[index]->node_; }
+
+		/**
+		 * @brief 当前线程的 NUMA 节点，作为分配内存的节点提示（配合 cpu::numa_alloc）
+		 * 本池 worker 返回其分组节点，其他线程返回当前运行 CPU 所在节点
+		 */
+		u64 current_node() const noexcept {
+			tls_info &info = tls();
+			return info.pool_ == this ? workers_[info.index_]->node_ : cpu::current_node();
+		}
+
+		// 当前 worker 本地队列中的任务数，非本池 worker 返回 0；用于自适应拆分
+		u64 local_task_count() const noexcept {
+			tls_info &info = tls();
+			return info.pool_ == this ? workers_[info.index_]->deque_.size() : 0;
+		}
+
+		// ============================
+		// 协作执行
+		// ============================
+
+		/**
+		 * @brief 在调用线程上执行一个待处理任务
+		 * worker 线程优先取本地队列；外部线程只从注入队列和窃取获取
+		 * @return 是否执行了任务
+		 */
+		bool run_pending_task() {
+			tls_info &info = tls();
+			task_ptr t = info.pool_ == this ? find_task(info.index_) : find_task(npos);
+			if (t == nullptr) {
+				return false;
+			}
+			finish(t, true);
+			return true;
+		}
+
+		/**
+		 * @brief 等待条件成立，期间帮助执行任务
+		 * 在 worker 中等待子任务时必须使用此函数，否则可能因所有 worker 阻塞而死锁
+		 */
+		template <class Pred>
+		void wait_until(Pred &&done) {
+			u64 idle = 0;
+			while (!done()) {
+				if (run_pending_task()) {
+					idle = 0;
+					continue;
+				}
+				if (++idle < idle_spin_count_) {
+					cpu::relax();
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		// ============================
+		// 空闲钩子
+		// ============================
+
+		/**
+		 * @brief 安装空闲钩子，同一时刻只能有一个
+		 * @param hook 由调用方持有，卸载前必须保持有效
+		 * @return 已有其他钩子时返回 false
+		 */
+		bool install_idle_hook(const idle_hook *hook) noexcept {
+			const idle_hook *expected = nullptr;
+			return idle_hook_.compare_exchange_strong(expected, hook, std::memory_order_seq_cst);
+		}
+
+		// 卸载空闲钩子，返回时保证没有 worker 仍在调用它
+		void remove_idle_hook(const idle_hook *hook) noexcept {
+			const idle_hook *expected = hook;
+			idle_hook_.compare_exchange_strong(expected, nullptr, std::memory_order_seq_cst);
+			while (hook_users_.load(std::memory_order_seq_cst) != 0) {
+				std::this_thread::yield();
+			}
+		}
+
+		// 当前线程所属的线程池，非 worker 线程返回 nullptr
+		inline static thread_pool *current() noexcept { return tls().pool_; }
+
+		// 当前线程在所属线程池中的序号，非 worker 线程返回 npos
+		inline static u64 current_index() noexcept { return tls().index_; }
+
+	private:
+		// ============================
+		// 任务调度
+		// ============================
+
+		// pause 状态下阻塞外部提交，stop 后拒绝外部提交
+		void wait_for_submit() {
+			while (true) {
+				type s = state_.load(std::memory_order_acquire);
+				if (s == type::run) [[likely]]
+					return;
+				// worker 派生子任务不受 pause 限制，stop 期间 drain 队列时也允许派生
+				if ((s == type::pause || s == type::stop) && tls().pool_ == this)
+					return;
+				if (s == type::pause) {
+					state_.wait(type::pause, std::memory_order_acquire);
+					continue;
+				}
+				throw std::runtime_error("thread_pool stopped");
+			}
+		}
+
+		// 入队并唤醒空闲 worker
+		void schedule(task_ptr t, priority prio = priority::normal) {
+			tls_info &info = tls();
+			if (prio == priority::normal && info.pool_ == this) {
+				workers_[info.index_]->deque_.push(t);
+			} else {
+				lanes_[u64(prio)]->push(t);
+			}
+			notify_one();
+		}
+
+		/**
+		 * @brief 取下一个任务
+		 * strict: realtime 通道 -> 本地队列 -> normal 通道 -> 窃取 -> background 通道
+		 * weighted: 按权重轮转首选通道，首选为空时再按 strict 顺序查找
+		 */
+		task_ptr find_task(u64 self) {
+			if (lane_policy_ == lane_policy::weighted && self != npos) {
+				worker &w = *workers_[self];
+				u64 prio = lane_schedule_[w.tick_++ % lane_schedule_.size()];
+				if (task_ptr t = take_from(prio, self)) {
+					return t;
+				}
+			}
+			for (u64 prio = 0; prio < priority_count; ++prio) {
+				if (task_ptr t = take_from(prio, self)) {
+					return t;
+				}
+			}
+			return nullptr;
+		}
+
+		// 从某个优先级取任务；normal 级别包含本地队列与窃取
+		task_ptr take_from(u64 prio, u64 self) {
+			if (prio == u64(priority::normal)) {
+				if (self != npos) {
+					if (auto t = workers_[self]->deque_.take()) {
+						return *t;
+					}
+				}
+				if (task_ptr t = lanes_[prio]->pop()) {
+					return t;
+				}
+				return steal(self);
+			}
+			return lanes_[prio]->pop();
+		}
+
+		// 按权重展开成轮转表，例如 {2,1,1} -> [0,1,0,2]
+		void build_lane_schedule(const std::array<u32, priority_count> &weights) {
+			std::array<u32, priority_count> left = weights;
+			bool any = true;
+			while (any) {
+				any = false;
+				for (u64 prio = 0; prio < priority_count; ++prio) {
+					if (left[prio] > 0) {
+						lane_schedule_.push_back(prio);
+						left[prio]--;
+						any = true;
+					}
+				}
+			}
+			if (lane_schedule_.empty()) {
+				lane_schedule_.push_back(u64(priority::normal));
+			}
+		}
+
+		// 随机选择起点，遍历一轮受害者；NUMA 分组时先遍历同节点
+		task_ptr steal(u64 self) {
+			if (self == npos) {
+				u64 n = workers_.size();
+				u64 start = this_id() % n;
+				for (u64 i = 0; i < n; ++i) {
+					if (auto t = workers_[(start + i) % n]->deque_.steal()) {
+						return *t;
+					}
+				}
+				return nullptr;
+			}
+			worker &w = *workers_[self];
+			if (task_ptr t = steal_from(w, w.near_)) {
+				return t;
+			}
+			return steal_from(w, w.far_);
+		}
+
+		task_ptr steal_from(worker &w, const std::vector<u64> &victims) {
+			u64 n = victims.size();
+			if (n == 0) {
+				return nullptr;
+			}
+			u64 start = next_rand(w) % n;
+			for (u64 i = 0; i < n; ++i) {
+				if (auto t = workers_[victims[(start + i) % n]]->deque_.steal()) {
+					return *t;
+				}
+			}
+			return nullptr;
+		}
+
+		// 计算每个 worker 的节点、绑定 CPU 与窃取顺序
+		void place_workers(const pool_config &config) {
+			const cpu::topology &topo = cpu::topology::get();
+			const auto &cpus = topo.cpus(); // 已按节点分组排列
+			u64 n = workers_.size();
+
+			for (u64 i = 0; i < n; ++i) {
+				worker &w = *workers_[i];
+				// 按比例均匀铺开：相邻 worker 落在同一节点，各节点分到的 worker 数与其 CPU 数成正比
+				u32 cpu = cpus[i * cpus.size() / n];
+				w.node_ = config.numa_aware_ ? topo.node_index_of_cpu(cpu) : 0;
+				if (config.pin_threads_) {
+					w.affinity_ = {cpu};
+				} else if (config.numa_aware_) {
+					w.affinity_ = topo.nodes()[w.node_].cpus_;
+				}
+			}
+			for (u64 i = 0; i < n; ++i) {
+				worker &w = *workers_[i];
+				for (u64 j = 0; j < n; ++j) {
+					if (j == i)
+						continue;
+					(workers_[j]->node_ == w.node_ ? w.near_ : w.far_).push_back(j);
+				}
+			}
+		}
+
+		inline static u64 next_rand(worker &w) noexcept {
+			// xorshift64
+			u64 x = w.rng_;
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+			w.rng_ = x;
+			return x;
+		}
+
+		inline void finish(task_ptr t, bool run) {
+			struct guard_t {
+				task_ptr t_;
+				~guard_t() { detail::task_node::destroy(t_); }
+			} guard{t};
+			if (run) {
+				// 异常不能离开 worker_loop（否则 std::terminate），也不应从无关的 wait_until 中冒出
+				try {
+					t->func_();
+				} catch (...) {
+					report_exception(std::current_exception());
+				}
+			}
+		}
+
+		// 没有结果通道的异常：计数后交给 exception_handler_；处理器抛出时 std::terminate
+		void report_exception(std::exception_ptr e) noexcept {
+			unhandled_exceptions_.fetch_add(1, std::memory_order_relaxed);
+			if (exception_handler_) {
+				exception_handler_(std::move(e));
+			}
+		}
+
+		// ============================
+		// 空闲钩子调用
+		// ============================
+
+		/**
+		 * @brief 调用空闲钩子的 poll_；hook_users_ 计数保证 remove_idle_hook 之后不再有调用
+		 * 钩子抛出的异常（如定时器回调提交失败）与 post 任务的异常一样交给 report_exception
+		 */
+		inline bool poll_idle_hook() {
+			if (idle_hook_.load(std::memory_order_relaxed) == nullptr) [[likely]] {
+				return false;
+			}
+			hook_users_.fetch_add(1, std::memory_order_seq_cst);
+			const idle_hook *hook = idle_hook_.load(std::memory_order_seq_cst);
+			bool produced = false;
+			try {
+				produced = hook != nullptr && hook->poll_(hook->ctx_);
+			} catch (...) {
+				report_exception(std::current_exception());
+			}
+			hook_users_.fetch_sub(1, std::memory_order_release);
+			return produced;
+		}
+
+		// 钩子需要定时轮询时返回间隔，否则返回 0
+		inline std::chrono::nanoseconds idle_hook_interval() {
+			if (idle_hook_.load(std::memory_order_relaxed) == nullptr) [[likely]] {
+				return std::chrono::nanoseconds{0};
+			}
+			hook_users_.fetch_add(1, std::memory_order_seq_cst);
+			const idle_hook *hook = idle_hook_.load(std::memory_order_seq_cst);
+			std::chrono::nanoseconds interval{0};
+			if (hook != nullptr && hook->armed_(hook->ctx_)) {
+				interval = hook->interval_;
+			}
+			hook_users_.fetch_sub(1, std::memory_order_release);
+			return interval;
+		}
+
+		// ============================
+		// worker 挂起与唤醒
+		// ============================
+
+		// 发布任务后调用：只有存在挂起的 worker 时才付出 notify 的代价
+		inline void notify_one() noexcept {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (sleeping_.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+				wake_epoch_.fetch_add(1, std::memory_order_release);
+				wake_epoch_.notify_one();
+			}
+		}
+
+		inline void wake_all() noexcept {
+			wake_epoch_.fetch_add(1, std::memory_order_release);
+			wake_epoch_.notify_all();
+		}
+
+		void worker_loop(u64 index) {
+			tls_info &info = tls();
+			info.pool_ = this;
+			info.index_ = index;
+			if (!workers_[index]->affinity_.empty()) {
+				cpu::bind_this_thread(workers_[index]->affinity_);
+			}
+			detail::block_cache::this_cache() = workers_[index]->cache_;
+			detail::worker_hook::current() = {this, [](void *ctx) {
+												  return static_cast<thread_pool *>(ctx)->run_pending_task();
+											  }};
+
+			while (true) {
+				type s = state_.load(std::memory_order_acquire);
+				if (s == type::force_stop) {
+					break;
+				}
+
+				if (task_ptr t = find_task(index)) {
+					finish(t, true);
+					worker &w = *workers_[index];
+					if (++w.since_poll_ >= hook_poll_period_) {
+						w.since_poll_ = 0;
+						poll_idle_hook();
+					}
+					continue;
+				}
+
+				// 短暂自旋，覆盖提交与窃取之间的小空窗
+				bool found = false;
+				for (u64 i = 0; i < idle_spin_count_; ++i) {
+					cpu::relax();
+					if (task_count() != 0) {
+						found = true;
+						break;
+					}
+				}
+				if (found || poll_idle_hook()) {
+					continue;
+				}
+
+				// stop：队列已 drain，退出
+				if (s == type::stop) {
+					break;
+				}
+
+				// 计时者：钩子有待处理的工作时，一个 worker 按间隔小睡后回到循环轮询
+				std::chrono::nanoseconds interval = idle_hook_interval();
+				if (interval.count() > 0 && !timekeeper_.exchange(true, std::memory_order_acquire)) {
+					std::this_thread::sleep_for(interval);
+					timekeeper_.store(false, std::memory_order_release);
+					continue;
+				}
+
+				// 挂起：先读 epoch，再登记，再复查，保证提交方的唤醒不会丢失
+				u32 epoch = wake_epoch_.load(std::memory_order_acquire);
+				sleeping_.fetch_add(1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				type now = state_.load(std::memory_order_acquire);
+				if (task_count() == 0 && now != type::stop && now != type::force_stop) {
+					wake_epoch_.wait(epoch, std::memory_order_acquire);
+				}
+				sleeping_.fetch_sub(1, std::memory_order_relaxed);
+			}
+
+			info.pool_ = nullptr;
+			info.index_ = npos;
+			detail::block_cache::this_cache() = nullptr;
+			detail::worker_hook::current() = {};
+		}
+
+	private:
+		friend class timer_wheel;
+
+		// ============================
+		// 成员变量
+		// ============================
+		std::vector<std::unique_ptr<worker>> workers_; // worker 本地队列
+		std::vector<std::thread> threads_;			   // worker 线程
+		std::unique_ptr<detail::task_lane> lanes_[priority_count]; // 各优先级的全局注入通道
+		lane_policy lane_policy_ = lane_policy::strict;
+		std::vector<u64> lane_schedule_; // weighted 策略的轮转表
+		std::function<void(std::exception_ptr)> exception_handler_;
+		std::atomic<u64> unhandled_exceptions_{0};
+
+		CHENC_CACHE_ALIGN std::atomic<type> state_{type::init}; // 状态机
+		CHENC_CACHE_ALIGN std::atomic<u32> wake_epoch_{0};		// 唤醒版本号
+		CHENC_CACHE_ALIGN std::atomic<u32> sleeping_{0};		// 挂起的 worker 数
+		CHENC_CACHE_ALIGN std::atomic<const idle_hook *> idle_hook_{nullptr};
+		std::atomic<u32> hook_users_{0};   // 正在调用钩子的 worker 数
+		std::atomic<bool> timekeeper_{false}; // 是否已有 worker 担任计时者
+	};
+
+} // namespace chenc::thread
@@ -0,0 +1,454 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+#include "chenc/thread/lock.hpp"
+#include "chenc/thread/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chenc::thread {
+	// 定时器轮的驱动方式
+	enum class timer_drive : u8 {
+		tick_thread, // 独立的 tick 线程；没有定时器时挂起
+		idle_workers // 作为线程池的空闲钩子，由空闲 worker 推进；线程池满载时每 64 个任务推进一次
+	};
+
+	// 定时器轮配置
+	struct timer_config {
+		std::chrono::nanoseconds tick_ = std::chrono::milliseconds(1); // 时间精度
+		timer_drive drive_ = timer_drive::tick_thread;
+		priority priority_ = priority::normal; // 到期回调提交到的优先级通道
+	};
+
+	namespace detail {
+		// 定时器节点；由定时器轮的空闲链表回收，地址在轮的生命周期内稳定
+		struct timer_node {
+			timer_node *next_ = nullptr;
+			timer_node **pprev_ = nullptr; // 指向前一节点的 next_ 或槽头；nullptr 表示未挂在轮上
+			u64 expire_ = 0;			   // 到期 tick
+			task_node *task_ = nullptr;	   // 到期后提交的任务
+			u32 gen_ = 0;				   // 每次到期 / 取消后递增，使旧句柄失效
+		};
+	} // namespace detail
+
+	// 定时器句柄
+	class timer_id {
+	public:
+		timer_id() noexcept = default;
+		inline bool valid() const noexcept { return node_ != nullptr; }
+
+	private:
+		friend class timer_wheel;
+		timer_id(detail::timer_node *node, u32 gen) noexcept
+			: node_(node), gen_(gen) {}
+
+		detail::timer_node *node_ = nullptr;
+		u32 gen_ = 0;
+	};
+
+	/**
+	 * @brief 分层时间轮
+	 * - 4 层 × 256 槽，覆盖 2^32 个 tick（1ms 精度约 49 天），更远的定时器在最高层循环等待
+	 * - 插入 / 取消为 O(1)：槽内是侵入式双向链表，节点从空闲链表回收
+	 * - 回调与线程池共用 task 节点，捕获不超过 task 内联缓冲区时，稳态下的插入、取消、到期都不分配内存
+	 * - 到期回调提交到线程池执行，而不是在推进时间的线程上执行
+	 * 必须在线程池之前销毁；销毁时未到期的回调被丢弃（不执行）。
+	 */
+	class timer_wheel {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		inline static constexpr u64 level_bits = 8;
+		inline static constexpr u64 slot_count = u64(1) << level_bits;
+		inline static constexpr u64 level_count = 4;
+		inline static constexpr u64 max_span = u64(1) << (level_bits * level_count); // 可直接表示的最大 tick 差
+
+	private:
+		using node = detail::timer_node;
+
+		// 每次补充的节点数
+		inline static constexpr u64 chunk_nodes = 256;
+
+	public:
+		explicit timer_wheel(thread_pool &pool, const timer_config &config = {})
+			: pool_(pool),
+			  tick_ns_(std::max<i64>(config.tick_.count(), 1)),
+			  drive_(config.drive_),
+			  priority_(config.priority_),
+			  origin_(clock::now()) {
+			if (drive_ == timer_drive::idle_workers) {
+				hook_ = {this,
+						 [](void *ctx) { return static_cast<timer_wheel *>(ctx)->poll() != 0; },
+						 [](void *ctx) { return static_cast<timer_wheel *>(ctx)->size() != 0; },
+						 std::chrono::nanoseconds(tick_ns_)};
+				if (!pool_.install_idle_hook(&hook_)) {
+					throw std::logic_error("timer_wheel: thread_pool already has an idle hook");
+				}
+			} else {
+				ticker_ = std::thread(&timer_wheel::tick_loop, this);
+			}
+		}
+
+		timer_wheel(const timer_wheel &) = delete;
+		timer_wheel &operator=(const timer_wheel &) = delete;
+
+		~timer_wheel() {
+			if (drive_ == timer_drive::idle_workers) {
+				pool_.remove_idle_hook(&hook_);
+			} else {
+				stop_.store(true, std::memory_order_seq_cst);
+				ticker_epoch_.fetch_add(1, std::memory_order_seq_cst);
+				ticker_epoch_.notify_one();
+				ticker_.join();
+			}
+			for (auto &level : slots_) {
+				for (node *head : level) {
+					for (node *n = head; n != nullptr; n = n->next_) {
+						detail::task_node::destroy(n->task_);
+					}
+				}
+			}
+		}
+
+		// ============================
+		// 定时器
+		// ============================
+
+		// 在 delay 之后执行 f；精度为一个 tick，不会提前执行
+		template <class F>
+		timer_id schedule_after(clock::duration delay, F &&f) {
+			return schedule_at(clock::now() + delay, std::forward<F>(f));
+		}
+
+		// 在 when 时刻之后执行 f
+		template <class F>
+		timer_id schedule_at(clock::time_point when, F &&f) {
+			detail::task_node *t = detail::task_node::make(std::forward<F>(f));
+			u64 tick = to_tick(when, true);
+			u64 before;
+			timer_id id;
+			{
+				std::scoped_lock guard(mtx_);
+				node *n = nullptr;
+				try {
+					n = alloc_node();
+				} catch (...) {
+					detail::task_node::destroy(t);
+					throw;
+				}
+				n->task_ = t;
+				n->expire_ = std::max(tick, current_.load(std::memory_order_relaxed) + 1);
+				link(n);
+				before = count_.fetch_add(1, std::memory_order_seq_cst);
+				id = timer_id(n, n->gen_);
+			}
+			// 轮由空变为非空：唤醒挂起的驱动者
+			if (before == 0) {
+				wake_driver();
+			}
+			return id;
+		}
+
+		/**
+		 * @brief 取消定时器
+		 * @return 定时器尚未到期且被取消时返回 true；已到期、已取消或句柄无效时返回 false
+		 */
+		bool cancel(timer_id id) noexcept {
+			if (!id.valid()) {
+				return false;
+			}
+			detail::task_node *t = nullptr;
+			{
+				std::scoped_lock guard(mtx_);
+				node *n = id.node_;
+				if (n->gen_ != id.gen_ || n->pprev_ == nullptr) {
+					return false;
+				}
+				unlink(n);
+				t = n->task_;
+				free_node(n);
+				count_.fetch_sub(1, std::memory_order_relaxed);
+			}
+			detail::task_node::destroy(t); // 回调的捕获在锁外析构
+			return true;
+		}
+
+		/**
+		 * @brief 推进到当前时间，将到期回调提交到线程池
+		 * 可以由任意线程调用；已有线程在推进时直接返回。
+		 * @return 本次提交的回调数
+		 */
+		u64 poll() {
+			u64 now = to_tick(clock::now(), false);
+			if (now <= current_.load(std::memory_order_acquire)) {
+				return 0;
+			}
+
+			node *fired = nullptr;
+			node *tail = nullptr;
+			u64 fired_count = 0;
+			{
+				std::unique_lock guard(mtx_, std::try_to_lock);
+				if (!guard.owns_lock()) {
+					return 0;
+				}
+				advance(now, fired, tail, fired_count);
+			}
+			if (fired == nullptr) {
+				return 0;
+			}
+
+			// 锁外提交：节点已失效（gen_ 已递增），取消会失败。
+			// submit 抛出（如注入队列扩容失败）时，守卫把尚未提交的回调挂回轮上、下一个 tick 再提交，
+			// 其余节点照常归还空闲链表，异常继续向外传播（挂回的回调句柄已失效，不能再取消）
+			struct requeue_guard {
+				timer_wheel &wheel_;
+				node *fired_;
+				~requeue_guard() { wheel_.recycle_fired(fired_); }
+			} guard{*this, fired};
+			for (node *n = fired; n != nullptr; n = n->next_) {
+				submit(n->task_);
+				n->task_ = nullptr;
+			}
+			return fired_count;
+		}
+
+		// 尚未到期的定时器数（非严格一致）
+		u64 size() const noexcept { return count_.load(std::memory_order_relaxed); }
+
+		std::chrono::nanoseconds tick() const noexcept { return std::chrono::nanoseconds(tick_ns_); }
+
+	private:
+		// ============================
+		// 时间
+		// ============================
+
+		// 时刻对应的 tick；到期时刻向上取整、当前时刻向下取整，保证不会提前到期
+		inline u64 to_tick(clock::time_point t, bool round_up) const noexcept {
+			i64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t - origin_).count();
+			if (ns <= 0) {
+				return 0;
+			}
+			return (u64(ns) + (round_up ? u64(tick_ns_) - 1 : 0)) / u64(tick_ns_);
+		}
+
+		// ============================
+		// 时间轮操作（持有 mtx_）
+		// ============================
+
+		// 按与当前 tick 的距离选择层与槽
+		inline void link(node *n) noexcept {
+			u64 now = current_.load(std::memory_order_relaxed);
+			u64 delta = n->expire_ - now;
+			u64 at = delta >= max_span ? now + max_span - 1 : n->expire_; // 过远的定时器先放在最高层
+			u64 level = 0;
+			while (level + 1 < level_count && (at - now) >= (u64(1) << (level_bits * (level + 1)))) {
+				++level;
+			}
+			node *&head = slots_[level][(at >> (level_bits * level)) & (slot_count - 1)];
+			n->next_ = head;
+			if (head != nullptr) {
+				head->pprev_ = &n->next_;
+			}
+			head = n;
+			n->pprev_ = &head;
+		}
+
+		inline static void unlink(node *n) noexcept {
+			*n->pprev_ = n->next_;
+			if (n->next_ != nullptr) {
+				n->next_->pprev_ = n->pprev_;
+			}
+			n->next_ = nullptr;
+			n->pprev_ = nullptr;
+		}
+
+		// 将较高层的一个槽重新分配到较低层
+		inline void cascade(u64 level, u64 slot) noexcept {
+			node *n = std::exchange(slots_[level][slot], nullptr);
+			while (n != nullptr) {
+				node *next = n->next_;
+				link(n);
+				n = next;
+			}
+		}
+
+		// 逐 tick 推进到 now，到期节点串成 fired 链表
+		void advance(u64 now, node *&fired, node *&tail, u64 &fired_count) noexcept {
+			if (count_.load(std::memory_order_relaxed) == 0) {
+				current_.store(now, std::memory_order_release);
+				return;
+			}
+			u64 t = current_.load(std::memory_order_relaxed);
+			while (t < now) {
+				++t;
+				current_.store(t, std::memory_order_release);
+
+				// 低层转完一圈时，从高层取下一段
+				for (u64 level = 1; level < level_count; ++level) {
+					if ((t & ((u64(1) << (level_bits * level)) - 1)) != 0) {
+						break;
+					}
+					cascade(level, (t >> (level_bits * level)) & (slot_count - 1));
+				}
+
+				node *n = std::exchange(slots_[0][t & (slot_count - 1)], nullptr);
+				while (n != nullptr) {
+					node *next = n->next_;
+					n->pprev_ = nullptr;
+					n->gen_++;
+					n->next_ = nullptr;
+					if (tail == nullptr) {
+						fired = n;
+					} else {
+						tail->next_ = n;
+					}
+					tail = n;
+					fired_count++;
+					count_.fetch_sub(1, std::memory_order_relaxed);
+					n = next;
+				}
+				if (count_.load(std::memory_order_relaxed) == 0) {
+					current_.store(now, std::memory_order_release);
+					return;
+				}
+			}
+		}
+
+		// poll 提交结束后处理到期链表：已提交的节点归还空闲链表，未提交的重新挂到下一个 tick
+		void recycle_fired(node *fired) noexcept {
+			u64 requeued = 0;
+			u64 before = 0;
+			{
+				std::scoped_lock guard(mtx_);
+				node *n = fired;
+				while (n != nullptr) {
+					node *next = n->next_;
+					if (n->task_ == nullptr) [[likely]] {
+						n->next_ = free_;
+						free_ = n;
+					} else {
+						n->expire_ = current_.load(std::memory_order_relaxed) + 1;
+						link(n);
+						requeued++;
+					}
+					n = next;
+				}
+				if (requeued == 0) [[likely]] {
+					return;
+				}
+				before = count_.fetch_add(requeued, std::memory_order_seq_cst);
+			}
+			if (before == 0) {
+				wake_driver();
+			}
+		}
+
+		inline node *alloc_node() {
+			if (free_ == nullptr) [[unlikely]] {
+				refill();
+			}
+			node *n = free_;
+			free_ = n->next_;
+			n->next_ = nullptr;
+			return n;
+		}
+
+		inline void free_node(node *n) noexcept {
+			n->gen_++;
+			n->task_ = nullptr;
+			n->next_ = free_;
+			free_ = n;
+		}
+
+		CHENC_NO_INLINE void refill() {
+			std::unique_ptr<node[]> chunk(new node[chunk_nodes]);
+			for (u64 i = 0; i < chunk_nodes; ++i) {
+				chunk[i].next_ = i + 1 < chunk_nodes ? &chunk[i + 1] : nullptr;
+			}
+			free_ = &chunk[0];
+			chunks_.emplace_back(std::move(chunk));
+		}
+
+		// ============================
+		// 驱动
+		// ============================
+
+		inline void wake_driver() noexcept {
+			if (drive_ == timer_drive::tick_thread) {
+				ticker_epoch_.fetch_add(1, std::memory_order_seq_cst);
+				ticker_epoch_.notify_one();
+			} else {
+				pool_.notify_one();
+			}
+		}
+
+		// 提交到线程池；线程池已停止时丢弃
+		inline void submit(detail::task_node *t) {
+			thread_pool::type s = pool_.state();
+			if (s == thread_pool::type::stop || s == thread_pool::type::force_stop) {
+				detail::task_node::destroy(t);
+				return;
+			}
+			pool_.schedule(t, priority_);
+		}
+
+		// tick 线程：对齐到 tick 边界推进；轮为空时挂起直到有新定时器
+		void tick_loop() {
+			const std::chrono::nanoseconds tick(tick_ns_);
+			clock::time_point next = clock::now();
+			while (!stop_.load(std::memory_order_acquire)) {
+				u32 epoch = ticker_epoch_.load(std::memory_order_seq_cst);
+				if (count_.load(std::memory_order_seq_cst) == 0) {
+					if (stop_.load(std::memory_order_acquire)) {
+						break;
+					}
+					ticker_epoch_.wait(epoch, std::memory_order_seq_cst);
+					next = clock::now();
+					continue;
+				}
+				next += tick;
+				clock::time_point now = clock::now();
+				if (next < now) {
+					next = now; // 落后时不追赶睡眠，poll 会一次推进多个 tick
+				}
+				std::this_thread::sleep_until(next);
+				// 提交失败的回调已挂回轮上，异常与空闲钩子驱动时一样交给线程池报告
+				try {
+					poll();
+				} catch (...) {
+					pool_.report_exception(std::current_exception());
+				}
+			}
+		}
+
+	private:
+		thread_pool &pool_;
+		const i64 tick_ns_;
+		const timer_drive drive_;
+		const priority priority_;
+		const clock::time_point origin_;
+
+		lock::mutex<> mtx_;
+		node *slots_[level_count][slot_count] = {};
+		node *free_ = nullptr;
+		std::vector<std::unique_ptr<node[]>> chunks_;
+
+		CHENC_CACHE_ALIGN std::atomic<u64> current_{0}; // 已处理到的 tick
+		CHENC_CACHE_ALIGN std::atomic<u64> count_{0};	// 挂在轮上的定时器数
+
+		thread_pool::idle_hook hook_{};
+		std::thread ticker_;
+		CHENC_CACHE_ALIGN std::atomic<u32> ticker_epoch_{0};
+		std::atomic<bool> stop_{false};
+	};
+} // namespace chenc::thread
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "chenc/core/cpp.hpp"
+#include "chenc/core/type.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace chenc::thread {
+	template <typename Sig, u64 BufferSize = CHENC_CACHE_LINE - sizeof(void *)>
+	class unique_function;
+
+	/**
+	 * @brief 只移动的函数包装器
+	 * 与 std::function 相比：不要求可拷贝，且内置 BufferSize 字节的小对象缓冲区。
+	 * 可调用对象满足 sizeof <= BufferSize、对齐 <= 指针对齐且移动构造 noexcept 时原地存放，
+	 * 否则回退到堆分配。默认尺寸使整个对象正好占一条缓存行。
+	 */
+	template <typename R, typename... Args, u64 BufferSize>
+	class unique_function<R(Args...), BufferSize> {
+	private:
+		struct vtable {
+			R (*invoke_)(void *self, Args &&...args);
+			void (*relocate_)(void *dst, void *src) noexcept; // 移动构造到 dst 并析构 src
+			void (*destroy_)(void *self) noexcept;
+		};
+
+		template <typename F>
+		inline static constexpr bool is_small_ = sizeof(F) <= BufferSize &&
+												 alignof(F) <= alignof(void *) &&
+												 std::is_nothrow_move_constructible_v<F>;
+
+		// 原地存放
+		template <typename F>
+		inline static constexpr vtable small_vtable_{
+			[](void *self, Args &&...args) -> R {
+				return std::invoke(*static_cast<F *>(self), std::forward<Args>(args)...);
+			},
+			[](void *dst, void *src) noexcept {
+				F *f = static_cast<F *>(src);
+				new (dst) F(std::move(*f));
+				f->~F();
+			},
+			[](void *self) noexcept {
+				static_cast<F *>(self)->~F();
+			}};
+
+		// 堆存放：缓冲区中只保存指针
+		template <typename F>
+		inline static constexpr vtable large_vtable_{
+			[](void *self, Args &&...args) -> R {
+				return std::invoke(**static_cast<F **>(self), std::forward<Args>(args)...);
+			},
+			[](void *dst, void *src) noexcept {
+				*static_cast<F **>(dst) = *static_cast<F **>(src);
+			},
+			[](void *self) noexcept {
+				delete *static_cast<F **>(self);
+			}};
+
+	public:
+		inline static constexpr u64 buffer_size = BufferSize;
+
+		unique_function() noexcept = default;
+		unique_function(std::nullptr_t) noexcept {}
+
+		template <typename F>
+			requires(!std::is_same_v<std::remove_cvref_t<F>, unique_function> &&
+					 std::is_invocable_r_v<R, std::decay_t<F> &, Args...>)
+		unique_function(F &&f) {
+			using D = std::decay_t<F>;
+			if constexpr (is_small_<D>) {
+				new (buf_) D(std::forward<F>(f));
+				vt_ = &small_vtable_<D>;
+			} else {
+				*reinterpret_cast<D **>(buf_) = new D(std::forward<F>(f));
+				vt_ = &large_vtable_<D>;
+			}
+		}
+
+		unique_function(unique_function &&other) noexcept {
+			if (other.vt_ != nullptr) {
+				other.vt_->relocate_(buf_, other.buf_);
+				vt_ = std::exchange(other.vt_, nullptr);
+			}
+		}
+
+		unique_function &operator=(unique_function &&other) noexcept {
+			if (this != &other) {
+				reset();
+				if (other.vt_ != nullptr) {
+					other.vt_->relocate_(buf_, other.buf_);
+					vt_ = std::exchange(other.vt_, nullptr);
+				}
+			}
+			return *this;
+		}
+
+		unique_function(const unique_function &) = delete;
+		unique_function &operator=(const unique_function &) = delete;
+
+		~unique_function() { reset(); }
+
+		inline R operator()(Args... args) {
+			return vt_->invoke_(buf_, std::forward<Args>(args)...);
+		}
+
+		inline explicit operator bool() const noexcept { return vt_ != nullptr; }
+
+		inline void reset() noexcept {
+			if (vt_ != nullptr) {
+				vt_->destroy_(buf_);
+				vt_ = nullptr;
+			}
+		}
+
+		// 可调用对象 F 是否能原地存放（不触发堆分配）
+		template <typename F>
+		inline static constexpr bool fits_inline() noexcept { return is_small_<std::decay_t<F>>; }
+
+	private:
+		alignas(void *) std::byte buf_[BufferSize];
+		const vtable *vt_ = nullptr;
+	};
+} // namespace chenc::thread
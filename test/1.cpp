@@ -1,26 +1,31 @@
 #include "chenc/thread/lock.hpp"
+#include "chenc/thread/olock.hpp"
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <format>
 #include <iostream>
 #include <numeric>
 #include <random>
 #include <shared_mutex>
 #include <mutex>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 using namespace chenc::lock;
 
+// 用法: 1 [mode] [spin_ns]
+// mode: std_shared（默认）| shared_mutex | std_mutex | spin
+// spin 模式下 spin_ns 设置 chenc::spin_lock 的全局自旋阈值（纳秒）
+// 没有 lock_shared 的独占锁，读操作也加独占锁
+template <typename Lock>
 struct test_bench {
 	static constexpr int duration_seconds = 10;
 	static constexpr int write_ratio = 0;
 
-	// spin_lock<> lock;
-	// shared_mutex<> lock;
-	std::shared_mutex lock;
-	// std::mutex lock;
+	Lock lock;
 	uint64_t shared_counter = 0;
 
 	struct metrics {
@@ -33,7 +38,8 @@ struct test_bench {
 	};
 };
 
-void benchmark_thread(int id, test_bench &bench, std::atomic<bool> &stop, test_bench::metrics &m) {
+template <typename Lock>
+void benchmark_thread(int id, test_bench<Lock> &bench, std::atomic<bool> &stop, typename test_bench<Lock>::metrics &m) {
 	std::mt19937 gen(id + std::time(nullptr));
 	std::uniform_int_distribution<> dist(1, 100);
 
@@ -43,7 +49,7 @@ void benchmark_thread(int id, test_bench &bench, std::atomic<bool> &stop, test_b
 		// 采样逻辑：每 1000 次操作进行一次精确计时，避免计时器本身成为瓶颈
 		bool should_sample = (m.read_ops + m.write_ops) % 1000 == 0;
 
-		if (chance <= test_bench::write_ratio) {
+		if (chance <= test_bench<Lock>::write_ratio) {
 			auto start = should_sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
 
 			bench.lock.lock();
@@ -61,12 +67,17 @@ void benchmark_thread(int id, test_bench &bench, std::atomic<bool> &stop, test_b
 		} else {
 			auto start = should_sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
 
-			bench.lock.lock_shared();
-			// bench.lock.lock();
-			volatile uint64_t val = bench.shared_counter;
-			(void)val;
-			bench.lock.unlock_shared();
-            // bench.lock.unlock();
+			if constexpr (requires { bench.lock.lock_shared(); }) {
+				bench.lock.lock_shared();
+				volatile uint64_t val = bench.shared_counter;
+				(void)val;
+				bench.lock.unlock_shared();
+			} else {
+				bench.lock.lock();
+				volatile uint64_t val = bench.shared_counter;
+				(void)val;
+				bench.lock.unlock();
+			}
 
 			if (should_sample) {
 				auto end = std::chrono::steady_clock::now();
@@ -80,22 +91,24 @@ void benchmark_thread(int id, test_bench &bench, std::atomic<bool> &stop, test_b
 	}
 }
 
-int main() {
-	test_bench bench;
-	unsigned int n_threads = std::thread::hardware_concurrency() / 2 ;
+template <typename Lock>
+int run_bench(std::string_view name) {
+	using bench_t = test_bench<Lock>;
+	bench_t bench;
+	unsigned int n_threads = std::max(1u, std::thread::hardware_concurrency() / 2);
 	std::vector<std::thread> threads;
-	std::vector<test_bench::metrics> thread_metrics(n_threads);
+	std::vector<typename bench_t::metrics> thread_metrics(n_threads);
 	std::atomic<bool> stop{false};
 
 	std::cout << "--- 读写锁延迟与吞吐测试 ---" << std::endl;
-	std::cout << std::format("线程数: {}, 读写比: {}%/{}%, 时长: {}s\n",
-							 n_threads, 100 - test_bench::write_ratio, test_bench::write_ratio, test_bench::duration_seconds);
+	std::cout << std::format("锁: {}, 线程数: {}, 读写比: {}%/{}%, 时长: {}s\n",
+							 name, n_threads, 100 - bench_t::write_ratio, bench_t::write_ratio, bench_t::duration_seconds);
 
 	for (unsigned int i = 0; i < n_threads; ++i) {
-		threads.emplace_back(benchmark_thread, i, std::ref(bench), std::ref(stop), std::ref(thread_metrics[i]));
+		threads.emplace_back(benchmark_thread<Lock>, i, std::ref(bench), std::ref(stop), std::ref(thread_metrics[i]));
 	}
 
-	std::this_thread::sleep_for(std::chrono::seconds(test_bench::duration_seconds));
+	std::this_thread::sleep_for(std::chrono::seconds(bench_t::duration_seconds));
 	stop.store(true, std::memory_order_release);
 
 	for (auto &t : threads)
@@ -115,7 +128,7 @@ int main() {
 	}
 
 	double avg_lat = total_samples > 0 ? (double)sum_latency / total_samples : 0;
-	double mops = (double)(total_reads + total_writes) / test_bench::duration_seconds / 1e6;
+	double mops = (double)(total_reads + total_writes) / bench_t::duration_seconds / 1e6;
 
 	std::cout << "--- 性能总结 ---" << std::endl;
 	std::cout << std::format("吞吐量: {:.2f} M ops/s\n", mops);
@@ -125,4 +138,23 @@ int main() {
 	std::cout << std::format("校验: {}\n", (bench.shared_counter == total_writes ? "PASS" : "FAIL"));
 
 	return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char **argv) {
+	std::string_view mode = argc > 1 ? argv[1] : "std_shared";
+	if (mode == "std_shared") {
+		return run_bench<std::shared_mutex>(mode);
+	} else if (mode == "shared_mutex") {
+		return run_bench<shared_mutex<>>(mode);
+	} else if (mode == "std_mutex") {
+		return run_bench<std::mutex>(mode);
+	} else if (mode == "spin") {
+		if (argc > 2) {
+			chenc::spin_lock::get_and_set_global_wait_start_time(std::strtoull(argv[2], nullptr, 10));
+		}
+		std::cout << std::format("spin_lock 自旋阈值: {} ns\n", chenc::spin_lock::get_and_set_global_wait_start_time());
+		return run_bench<chenc::spin_lock>(mode);
+	}
+	std::cerr << "用法: " << argv[0] << " [std_shared|shared_mutex|std_mutex|spin] [spin_ns]\n";
+	return 1;
+}
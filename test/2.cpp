@@ -17,8 +17,8 @@ struct test_bench {
     static constexpr int duration_seconds = 1;
     static constexpr int producer_ratio = 50;
 
-    // 存储 uint64_t 值，初始容量 1024
-    atomic_queue<uint64_t> queue{ uint64_t(1) << 27 };
+    // 存储 uint64_t 值，紧凑布局下每个槽位 16 字节
+    atomic_queue<uint64_t, queue_layout::compact> queue{ uint64_t(1) << 27 };
 
     struct metrics {
         uint64_t push_ops = 0;
@@ -0,0 +1,71 @@
+#include "chenc/thread/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace chenc::thread;
+
+struct test_bench {
+	static constexpr uint64_t task_count = 1'000'000; // 外部提交的任务数
+	static constexpr int fork_depth = 20;			  // fork-join 二叉树深度
+
+	thread_pool pool{std::thread::hardware_concurrency()};
+	std::atomic<uint64_t> done{0};
+};
+
+// worker 内部递归派生：测试本地队列 + 窃取路径
+void fork_join(test_bench &bench, int depth, std::atomic<uint64_t> &leaf) {
+	if (depth == 0) {
+		leaf.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	std::atomic<bool> right_done{false};
+	bench.pool.post([&] {
+		fork_join(bench, depth - 1, leaf);
+		right_done.store(true, std::memory_order_release);
+	});
+	fork_join(bench, depth - 1, leaf);
+	bench.pool.wait_until([&] { return right_done.load(std::memory_order_acquire); });
+}
+
+int main() {
+	test_bench bench;
+
+	std::cout << "--- 工作窃取线程池调度测试 ---" << std::endl;
+	std::cout << std::format("线程数: {}, 外部任务数: {}, fork-join 深度: {}\n",
+							 bench.pool.thread_count(), test_bench::task_count, test_bench::fork_depth);
+
+	// 1. 外部线程提交：注入队列路径
+	auto t1 = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < test_bench::task_count; ++i) {
+		bench.pool.post([&] { bench.done.fetch_add(1, std::memory_order_relaxed); });
+	}
+	bench.pool.wait_until([&] { return bench.done.load(std::memory_order_acquire) == test_bench::task_count; });
+	auto t2 = std::chrono::steady_clock::now();
+
+	// 2. worker 内部 fork-join
+	std::atomic<uint64_t> leaf{0};
+	auto fut = bench.pool.add_task([&] { fork_join(bench, test_bench::fork_depth, leaf); });
+	fut.get();
+	auto t3 = std::chrono::steady_clock::now();
+
+	bench.pool.stop();
+
+	double inject_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / test_bench::task_count;
+	uint64_t fork_tasks = (uint64_t(1) << test_bench::fork_depth) - 1;
+	double fork_ns = std::chrono::duration<double, std::nano>(t3 - t2).count() / fork_tasks;
+
+	std::cout << "--- 性能总结 ---" << std::endl;
+	std::cout << std::format("外部提交: {:.2f} ns/任务\n", inject_ns);
+	std::cout << std::format("fork-join: {:.2f} ns/任务\n", fork_ns);
+
+	bool passed = bench.done.load() == test_bench::task_count && leaf.load() == (uint64_t(1) << test_bench::fork_depth);
+	std::cout << std::format("校验: {}\n", (passed ? "PASS" : "FAIL"));
+
+	return passed ? 0 : 1;
+}
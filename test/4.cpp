@@ -0,0 +1,121 @@
+#include "chenc/thread/lock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace chenc::lock;
+
+struct test_bench {
+	static constexpr int threads = 4;
+	static constexpr int iterations = 100'000;
+
+	shared_mutex<> lock;
+	uint64_t value = 0;
+	uint64_t shadow = 0;
+};
+
+// 升级者等待读者离开期间，另一个写者限时加锁超时放弃：升级者不能因此错过唤醒
+bool upgrade_survives_abandoned_writer() {
+	shared_mutex<> lock;
+	std::atomic<bool> upgraded{false};
+	std::atomic<bool> reader_locked{false};
+	std::atomic<bool> release_reader{false};
+
+	lock.lock_upgrade();
+	std::thread reader([&] {
+		lock.lock_shared();
+		reader_locked.store(true, std::memory_order_release);
+		while (!release_reader.load(std::memory_order_acquire)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		lock.unlock_shared();
+	});
+	while (!reader_locked.load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+
+	std::thread upgrader([&] {
+		lock.upgrade_to_unique();
+		upgraded.store(true, std::memory_order_release);
+		lock.unlock();
+	});
+	// 等升级者挂起后再让写者超时
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+	bool writer_got = lock.try_lock_for(std::chrono::milliseconds(50));
+	release_reader.store(true, std::memory_order_release);
+	reader.join();
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!upgraded.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	bool passed = !writer_got && upgraded.load(std::memory_order_acquire);
+	if (!passed) {
+		std::cout << "升级者未被唤醒" << std::endl;
+		std::quick_exit(1);
+	}
+	upgrader.join();
+	return passed;
+}
+
+// 普通读者、写者与升级者混合：读到的 value 必须与 shadow 一致
+bool mixed_upgrade_stress(test_bench &bench) {
+	std::atomic<uint64_t> bad{0};
+	std::atomic<uint64_t> writes{0};
+	std::vector<std::thread> ts;
+	for (int t = 0; t < test_bench::threads; ++t) {
+		ts.emplace_back([&, t] {
+			for (int i = 0; i < test_bench::iterations; ++i) {
+				if (t == 0 && i % 16 == 0) {
+					bench.lock.lock_upgrade();
+					uint64_t seen = bench.value;
+					bench.lock.upgrade_to_unique();
+					if (seen != bench.value) {
+						bad.fetch_add(1, std::memory_order_relaxed);
+					}
+					bench.value++;
+					bench.shadow++;
+					writes.fetch_add(1, std::memory_order_relaxed);
+					bench.lock.unlock();
+				} else if (t == 1 && i % 64 == 0) {
+					if (bench.lock.try_lock_for(std::chrono::microseconds(10))) {
+						bench.value++;
+						bench.shadow++;
+						writes.fetch_add(1, std::memory_order_relaxed);
+						bench.lock.unlock();
+					}
+				} else {
+					bench.lock.lock_shared();
+					if (bench.value != bench.shadow) {
+						bad.fetch_add(1, std::memory_order_relaxed);
+					}
+					bench.lock.unlock_shared();
+				}
+			}
+		});
+	}
+	for (auto &t : ts) {
+		t.join();
+	}
+	return bad.load() == 0 && bench.value == writes.load();
+}
+
+int main() {
+	test_bench bench;
+
+	std::cout << "--- 读写锁升级测试 ---" << std::endl;
+	std::cout << std::format("线程数: {}, 每线程操作数: {}\n", test_bench::threads, test_bench::iterations);
+
+	bool abandoned = upgrade_survives_abandoned_writer();
+	std::cout << std::format("写者超时放弃后升级: {}\n", (abandoned ? "PASS" : "FAIL"));
+
+	bool mixed = mixed_upgrade_stress(bench);
+	std::cout << std::format("混合升级读写: {}\n", (mixed ? "PASS" : "FAIL"));
+
+	return abandoned && mixed ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+#include "chenc/thread/io_context.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace chenc;
+using namespace chenc::thread;
+
+struct test_bench {
+	static constexpr int rounds = 2000;		  // 每种 fd 的往返次数
+	static constexpr u64 chunk = 512;		  // 每次读写字节数
+	static constexpr int concurrent_reads = 64; // 先挂起、后写入的并发读请求数
+
+	thread_pool pool{std::max(2u, std::thread::hardware_concurrency())};
+};
+
+// 一对 fd 上的往返：写端写入 chunk 字节，读端读满后校验
+co_task<bool> ping_pong(io_context &io, int rd, int wr, bool use_socket) {
+	std::array<std::byte, test_bench::chunk> out{};
+	std::array<std::byte, test_bench::chunk> in{};
+	for (int i = 0; i < test_bench::rounds; ++i) {
+		std::memset(out.data(), i & 0xFF, out.size());
+		i64 w = use_socket ? co_await io.send(wr, out) : co_await io.write(wr, out);
+		if (w != i64(out.size())) {
+			co_return false;
+		}
+		u64 got = 0;
+		while (got < in.size()) {
+			auto rest = std::span(in).subspan(got);
+			i64 r = use_socket ? co_await io.recv(rd, rest) : co_await io.read(rd, rest);
+			if (r <= 0) {
+				co_return false;
+			}
+			got += u64(r);
+		}
+		if (std::memcmp(in.data(), out.data(), in.size()) != 0) {
+			co_return false;
+		}
+	}
+	co_return true;
+}
+
+// 读请求先挂起等待数据，写入后才完成：覆盖反应器阻塞期间的提交与唤醒
+co_task<bool> pending_read(io_context &io, int rd) {
+	std::array<std::byte, 1> b{};
+	i64 r = co_await io.read(rd, b);
+	co_return r == 1 && b[0] == std::byte{'x'};
+}
+
+// 分离运行的协程计数：worker 不能阻塞在 sync_wait 上，否则完成的协程没有线程恢复
+struct spawn_counter {
+	std::atomic<int> done{0};
+	std::atomic<int> passed{0};
+
+	co_task<void> track(co_task<bool> t) {
+		bool ok = co_await std::move(t);
+		passed.fetch_add(ok ? 1 : 0, std::memory_order_relaxed);
+		done.fetch_add(1, std::memory_order_release);
+	}
+
+	// 等待 n 个协程结束（最多 10 秒），返回是否全部通过
+	bool wait(int n) const {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (done.load(std::memory_order_acquire) < n) {
+			if (std::chrono::steady_clock::now() >= deadline) {
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return passed.load(std::memory_order_relaxed) == n;
+	}
+};
+
+bool test_pipe(io_context &io) {
+	int fds[2];
+	if (::pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+		return false;
+	}
+	bool ok = sync_wait(ping_pong(io, fds[0], fds[1], false));
+
+	// 多个读请求同时挂起，然后逐个字节喂入
+	coroutine_run_manager mgr(io.pool());
+	spawn_counter reads;
+	for (int i = 0; i < test_bench::concurrent_reads; ++i) {
+		mgr.spawn(reads.track(pending_read(io, fds[0])));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	for (int i = 0; i < test_bench::concurrent_reads; ++i) {
+		ok = ::write(fds[1], "x", 1) == 1 && ok;
+	}
+	ok = reads.wait(test_bench::concurrent_reads) && ok;
+
+	::close(fds[0]);
+	::close(fds[1]);
+	return ok;
+}
+
+bool test_socketpair(io_context &io) {
+	int fds[2];
+	if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds) != 0) {
+		return false;
+	}
+	// 两个方向同时往返
+	coroutine_run_manager mgr(io.pool());
+	spawn_counter both;
+	mgr.spawn(both.track(ping_pong(io, fds[0], fds[1], true)));
+	mgr.spawn(both.track(ping_pong(io, fds[1], fds[0], true)));
+	bool ok = both.wait(2);
+
+	// 对端关闭后 recv 返回 0
+	::close(fds[1]);
+	std::array<std::byte, 8> buf{};
+	ok = ok && sync_wait([](io_context &io, int fd, std::span<std::byte> b) -> co_task<i64> {
+				   co_return co_await io.recv(fd, b);
+			   }(io, fds[0], buf)) == 0;
+	::close(fds[0]);
+	return ok;
+}
+
+// tmpfs（/dev/shm）上的普通文件：带偏移写入后按偏移读回，并检查越过文件末尾的读
+bool test_tmpfs_file(io_context &io) {
+	char path[] = "/dev/shm/chenc_io_XXXXXX";
+	int fd = ::mkstemp(path);
+	if (fd < 0) {
+		return false;
+	}
+	::unlink(path);
+
+	bool ok = sync_wait([](io_context &io, int fd) -> co_task<bool> {
+		std::array<std::byte, test_bench::chunk> block{};
+		for (u64 i = 0; i < 64; ++i) {
+			std::memset(block.data(), int(i), block.size());
+			if (co_await io.write(fd, block, i * block.size()) != i64(block.size())) {
+				co_return false;
+			}
+		}
+		for (u64 i = 64; i-- > 0;) {
+			std::array<std::byte, test_bench::chunk> back{};
+			if (co_await io.read(fd, back, i * back.size()) != i64(back.size())) {
+				co_return false;
+			}
+			if (back[0] != std::byte(i) || back[back.size() - 1] != std::byte(i)) {
+				co_return false;
+			}
+		}
+		std::array<std::byte, 16> tail{};
+		co_return co_await io.read(fd, tail, 64 * test_bench::chunk) == 0;
+	}(io, fd));
+
+	// 注册文件 + 注册缓冲区
+	std::array<std::byte, 64> fixed_buf{};
+	iovec iov{fixed_buf.data(), fixed_buf.size()};
+	int table[] = {fd};
+	if (io.register_files(table) && io.register_buffers(std::span(&iov, 1))) {
+		i64 w = sync_wait([](io_context &io, std::span<std::byte> b) -> co_task<i64> {
+			std::memcpy(b.data(), "fixed", 5);
+			co_return co_await io.write_fixed(fixed_file{0}, b.first(5), 0, 0);
+		}(io, fixed_buf));
+		char check[5] = {};
+		ok = ok && w == 5 && ::pread(fd, check, 5, 0) == 5 && std::memcmp(check, "fixed", 5) == 0;
+		io.unregister_buffers();
+		io.unregister_files();
+	}
+
+	::close(fd);
+	return ok;
+}
+
+bool run_backend(thread_pool &pool, io_backend backend, std::string_view name) {
+	std::unique_ptr<io_context> io;
+	try {
+		io = std::make_unique<io_context>(pool, io_config{.entries_ = 16, .backend_ = backend});
+	} catch (const std::system_error &e) {
+		std::cout << std::format("{}: 不可用（{}），跳过\n", name, e.what());
+		return true;
+	}
+	bool pipe_ok = test_pipe(*io);
+	bool sock_ok = test_socketpair(*io);
+	bool file_ok = test_tmpfs_file(*io);
+	std::cout << std::format("{}: pipe {}, socketpair {}, tmpfs {}\n", name, (pipe_ok ? "PASS" : "FAIL"),
+							 (sock_ok ? "PASS" : "FAIL"), (file_ok ? "PASS" : "FAIL"));
+	return pipe_ok && sock_ok && file_ok;
+}
+
+int main() {
+	test_bench bench;
+
+	std::cout << "--- io_context 测试 ---" << std::endl;
+	std::cout << std::format("线程数: {}, 往返次数: {}, 块大小: {}\n",
+							 bench.pool.thread_count(), test_bench::rounds, test_bench::chunk);
+
+	bool uring_ok = run_backend(bench.pool, io_backend::uring, "io_uring");
+	bool epoll_ok = run_backend(bench.pool, io_backend::epoll, "epoll");
+
+	bench.pool.stop();
+
+	bool passed = uring_ok && epoll_ok;
+	std::cout << std::format("校验: {}\n", (passed ? "PASS" : "FAIL"));
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include "chenc/thread/task_graph.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace chenc::thread;
+
+struct test_bench {
+	static constexpr int runs = 2000;  // 同一张图的重复运行次数
+	static constexpr int layers = 8;   // 分层图的层数
+	static constexpr int width = 16;   // 每层节点数
+};
+
+// 在独立线程里运行 fn，超过 5 秒未返回视为挂死：直接退出，避免测试卡住
+template <typename F>
+bool finishes_in_time(F &&fn) {
+	std::atomic<bool> done{false};
+	std::thread t([&] {
+		fn();
+		done.store(true, std::memory_order_release);
+	});
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!done.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	if (!done.load(std::memory_order_acquire)) {
+		std::cout << "task_graph::run() 未返回" << std::endl;
+		std::quick_exit(1);
+	}
+	t.join();
+	return true;
+}
+
+// 分层全连接图：每个节点执行时，上一层必须已全部完成
+bool layered_order(thread_pool &pool) {
+	task_graph g;
+	std::vector<std::atomic<int>> finished(test_bench::layers);
+	std::atomic<int> bad{0};
+	std::vector<task_graph::node_ref> prev;
+	for (int l = 0; l < test_bench::layers; ++l) {
+		std::vector<task_graph::node_ref> cur;
+		for (int i = 0; i < test_bench::width; ++i) {
+			auto n = g.emplace([&, l] {
+				if (l > 0 && finished[l - 1].load(std::memory_order_acquire) != test_bench::width) {
+					bad.fetch_add(1, std::memory_order_relaxed);
+				}
+				finished[l].fetch_add(1, std::memory_order_acq_rel);
+			});
+			for (auto &p : prev) {
+				p.precede(n);
+			}
+			cur.push_back(n);
+		}
+		prev = std::move(cur);
+	}
+	for (int r = 0; r < test_bench::runs; ++r) {
+		for (auto &f : finished) {
+			f.store(0, std::memory_order_relaxed);
+		}
+		g.run(pool);
+		if (finished[test_bench::layers - 1].load() != test_bench::width) {
+			return false;
+		}
+	}
+	return bad.load() == 0;
+}
+
+// 节点抛出的异常在 run() 中重新抛出，其后继被跳过
+bool node_exception(thread_pool &pool) {
+	task_graph g;
+	std::atomic<bool> after{false};
+	auto [a, b] = g.emplace([] { throw std::runtime_error("boom"); },
+							[&] { after.store(true, std::memory_order_relaxed); });
+	a.precede(b);
+	try {
+		g.run(pool);
+	} catch (const std::runtime_error &) {
+		return !after.load();
+	}
+	return false;
+}
+
+// A 运行期间 stop(false)：A 的后继提交失败，run() 必须返回并报告错误
+bool stop_during_run() {
+	thread_pool pool{2};
+	task_graph g;
+	auto a = g.emplace([] { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+	auto b = g.emplace([] {});
+	auto c = g.emplace([] {});
+	a.precede(b, c);
+
+	bool threw = false;
+	std::thread stopper([&] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		pool.stop(false);
+	});
+	finishes_in_time([&] {
+		try {
+			g.run(pool);
+		} catch (const std::exception &) {
+			threw = true;
+		}
+	});
+	stopper.join();
+	return threw;
+}
+
+// 已提交但尚未开始的根被 stop(false) 丢弃：run() 同样要返回
+bool stop_drops_roots() {
+	thread_pool pool{1};
+	std::atomic<bool> blocker_started{false};
+	pool.post([&] {
+		blocker_started.store(true, std::memory_order_release);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	});
+	while (!blocker_started.load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+
+	task_graph g;
+	std::atomic<int> ran{0};
+	for (int i = 0; i < 8; ++i) {
+		g.emplace([&] { ran.fetch_add(1, std::memory_order_relaxed); });
+	}
+	bool threw = false;
+	std::thread stopper([&] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		pool.stop(false);
+	});
+	finishes_in_time([&] {
+		try {
+			g.run(pool);
+		} catch (const std::exception &) {
+			threw = true;
+		}
+	});
+	stopper.join();
+	return threw && ran.load() == 0;
+}
+
+// 在已停止的线程池上运行：所有根都提交失败
+bool run_on_stopped_pool() {
+	thread_pool pool{1};
+	pool.stop();
+	task_graph g;
+	auto [a, b] = g.emplace([] {}, [] {});
+	a.precede(b);
+	bool threw = false;
+	finishes_in_time([&] {
+		try {
+			g.run(pool);
+		} catch (const std::runtime_error &) {
+			threw = true;
+		}
+	});
+	return threw;
+}
+
+int main() {
+	thread_pool pool{std::max(2u, std::thread::hardware_concurrency())};
+
+	std::cout << "--- task_graph 测试 ---" << std::endl;
+	std::cout << std::format("线程数: {}, 层数: {}, 每层节点: {}, 运行次数: {}\n", pool.thread_count(),
+							 test_bench::layers, test_bench::width, test_bench::runs);
+
+	bool order = layered_order(pool);
+	std::cout << std::format("分层依赖顺序: {}\n", (order ? "PASS" : "FAIL"));
+	bool exc = node_exception(pool);
+	std::cout << std::format("节点异常传播: {}\n", (exc ? "PASS" : "FAIL"));
+	pool.stop();
+
+	bool stop_run = stop_during_run();
+	std::cout << std::format("运行中 stop(false): {}\n", (stop_run ? "PASS" : "FAIL"));
+	bool dropped = stop_drops_roots();
+	std::cout << std::format("根被丢弃: {}\n", (dropped ? "PASS" : "FAIL"));
+	bool stopped = run_on_stopped_pool();
+	std::cout << std::format("已停止的线程池: {}\n", (stopped ? "PASS" : "FAIL"));
+
+	bool passed = order && exc && stop_run && dropped && stopped;
+	std::cout << std::format("校验: {}\n", (passed ? "PASS" : "FAIL"));
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+#include "chenc/thread/channel.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace chenc;
+using namespace chenc::thread;
+
+struct test_bench {
+	static constexpr int producers = 4;		  // 每个通道的生产者数
+	static constexpr int consumers = 3;		  // 每个通道的普通消费者数
+	static constexpr u64 items = 20'000;	  // 每个生产者发送的元素数
+	static constexpr u64 bounded_capacity = 8; // 有界通道容量，足够小以频繁挂起发送者
+	static constexpr int select_rounds = 20;  // select 测试的重复次数
+
+	thread_pool pool{std::max(2u, std::thread::hardware_concurrency())};
+};
+
+// 元素编码：高 32 位为生产者编号，低 32 位为序号；同一生产者的序号在任一消费者处必须递增
+inline u64 encode(u64 producer, u64 seq) noexcept { return (producer << 32) | seq; }
+
+// 分离运行的协程计数：worker 不能阻塞在 sync_wait 上，否则完成的协程没有线程恢复
+struct spawn_counter {
+	std::atomic<int> done{0};
+	std::atomic<int> passed{0};
+
+	co_task<void> track(co_task<bool> t) {
+		bool ok = co_await std::move(t);
+		passed.fetch_add(ok ? 1 : 0, std::memory_order_relaxed);
+		done.fetch_add(1, std::memory_order_release);
+	}
+
+	// 等待 n 个协程结束（最多 20 秒），返回是否全部通过
+	bool wait(int n) const {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+		while (done.load(std::memory_order_acquire) < n) {
+			if (std::chrono::steady_clock::now() >= deadline) {
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return passed.load(std::memory_order_relaxed) == n;
+	}
+};
+
+// 消费结果汇总
+struct tally {
+	std::atomic<u64> count{0};
+	std::atomic<u64> sum{0};
+	std::atomic<u64> out_of_order{0};
+
+	// 记录一个元素，last 为本消费者见到的各生产者最大序号 + 1
+	template <u64 N>
+	inline void take(u64 v, std::array<u64, N> &last) {
+		u64 p = v >> 32;
+		u64 seq = v & 0xFFFF'FFFF;
+		if (p >= N || seq + 1 <= last[p]) {
+			out_of_order.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			last[p] = seq + 1;
+		}
+		count.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(v, std::memory_order_relaxed);
+	}
+
+	inline bool check(u64 producers, u64 first_producer = 0) const {
+		u64 expected_sum = 0;
+		for (u64 p = first_producer; p < first_producer + producers; ++p) {
+			for (u64 i = 0; i < test_bench::items; ++i) {
+				expected_sum += encode(p, i);
+			}
+		}
+		return count.load() == producers * test_bench::items && sum.load() == expected_sum &&
+			   out_of_order.load() == 0;
+	}
+};
+
+co_task<bool> produce(channel<u64> &ch, u64 producer) {
+	for (u64 i = 0; i < test_bench::items; ++i) {
+		if (!co_await ch.send(encode(producer, i))) {
+			co_return false;
+		}
+	}
+	co_return true;
+}
+
+co_task<bool> consume(channel<u64> &ch, tally &t) {
+	std::array<u64, 2 * test_bench::producers> last{};
+	while (std::optional<u64> v = co_await ch.recv()) {
+		t.take(*v, last);
+	}
+	co_return true;
+}
+
+co_task<bool> consume_batch(channel<u64> &ch, tally &t) {
+	std::array<u64, 2 * test_bench::producers> last{};
+	std::array<u64, 16> buf{};
+	while (u64 n = co_await ch.recv_batch(buf)) {
+		for (u64 i = 0; i < n; ++i) {
+			t.take(buf[i], last);
+		}
+	}
+	co_return true;
+}
+
+// 生产者全部结束后关闭通道，消费者取完剩余数据后退出
+co_task<bool> close_after(channel<u64> &ch, spawn_counter &producers, int n) {
+	while (producers.done.load(std::memory_order_acquire) < n) {
+		co_await schedule_on(*thread_pool::current());
+	}
+	ch.close();
+	co_return producers.passed.load() == n;
+}
+
+// 多生产者、多消费者（含批量接收）
+bool test_mpmc(thread_pool &pool, u64 capacity) {
+	channel<u64> ch(capacity);
+	coroutine_run_manager mgr(pool);
+	tally t;
+	spawn_counter producers;
+	spawn_counter rest;
+	for (int p = 0; p < test_bench::producers; ++p) {
+		mgr.spawn(producers.track(produce(ch, u64(p))));
+	}
+	for (int c = 0; c < test_bench::consumers; ++c) {
+		mgr.spawn(rest.track(c == 0 ? consume_batch(ch, t) : consume(ch, t)));
+	}
+	mgr.spawn(rest.track(close_after(ch, producers, test_bench::producers)));
+	bool ok = producers.wait(test_bench::producers) && rest.wait(test_bench::consumers + 1);
+	return ok && t.check(test_bench::producers);
+}
+
+// close 之后：send 失败，剩余数据仍可取出，取空后 recv 返回 std::nullopt
+bool test_close_drain(thread_pool &pool) {
+	channel<u64> ch(16);
+	for (u64 i = 0; i < 10; ++i) {
+		if (!ch.try_send(i)) {
+			return false;
+		}
+	}
+	ch.close();
+	u64 late = 99;
+	bool ok = !ch.try_send(late) && ch.closed();
+	ok = ok && sync_wait([](channel<u64> &ch) -> co_task<bool> {
+			 if (co_await ch.send(100)) {
+				 co_return false;
+			 }
+			 for (u64 i = 0; i < 10; ++i) {
+				 std::optional<u64> v = co_await ch.recv();
+				 if (!v.has_value() || *v != i) {
+					 co_return false;
+				 }
+			 }
+			 std::optional<u64> end = co_await ch.recv();
+			 co_return !end.has_value();
+		 }(ch));
+
+	// 挂起中的接收者在 close 时被唤醒并得到 std::nullopt
+	channel<u64> empty;
+	coroutine_run_manager mgr(pool);
+	spawn_counter waiters;
+	for (int i = 0; i < 8; ++i) {
+		mgr.spawn(waiters.track([](channel<u64> &ch) -> co_task<bool> {
+			co_return !(co_await ch.recv()).has_value();
+		}(empty)));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	empty.close();
+	return waiters.wait(8) && ok;
+}
+
+// 同时 select 两个通道，与普通接收者竞争；每个通道各有若干生产者
+co_task<bool> select_consume(channel<u64> &a, channel<u64> &b, tally &t) {
+	std::array<u64, 2 * test_bench::producers> last{};
+	bool a_open = true;
+	bool b_open = true;
+	while (a_open && b_open) {
+		auto r = co_await select(a, b);
+		std::optional<u64> &v = r.index() == 0 ? std::get<0>(r) : std::get<1>(r);
+		if (!v.has_value()) {
+			(r.index() == 0 ? a_open : b_open) = false;
+			continue;
+		}
+		t.take(*v, last);
+	}
+	// 一侧关闭取空后继续接收另一侧
+	channel<u64> &rest = a_open ? a : b;
+	while (std::optional<u64> v = co_await rest.recv()) {
+		t.take(*v, last);
+	}
+	co_return true;
+}
+
+bool test_select(thread_pool &pool, u64 capacity) {
+	for (int round = 0; round < test_bench::select_rounds; ++round) {
+		channel<u64> a(capacity);
+		channel<u64> b(capacity);
+		coroutine_run_manager mgr(pool);
+		tally t;
+		spawn_counter producers_a;
+		spawn_counter producers_b;
+		spawn_counter rest;
+		constexpr int half = test_bench::producers / 2;
+		for (int p = 0; p < half; ++p) {
+			mgr.spawn(producers_a.track(produce(a, u64(p))));
+			mgr.spawn(producers_b.track(produce(b, u64(half + p))));
+		}
+		mgr.spawn(rest.track(select_consume(a, b, t)));
+		mgr.spawn(rest.track(select_consume(a, b, t)));
+		mgr.spawn(rest.track(consume(a, t)));
+		mgr.spawn(rest.track(close_after(a, producers_a, half)));
+		mgr.spawn(rest.track(close_after(b, producers_b, half)));
+		bool ok = producers_a.wait(half) && producers_b.wait(half) && rest.wait(5);
+		if (!ok || !t.check(test_bench::producers)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	test_bench bench;
+
+	std::cout << "--- channel 测试 ---" << std::endl;
+	std::cout << std::format("线程数: {}, 生产者: {}, 消费者: {}, 每生产者元素数: {}\n", bench.pool.thread_count(),
+							 test_bench::producers, test_bench::consumers, test_bench::items);
+
+	bool unbounded = test_mpmc(bench.pool, channel<u64>::unbounded);
+	std::cout << std::format("无界通道多生产者多消费者: {}\n", (unbounded ? "PASS" : "FAIL"));
+	bool bounded = test_mpmc(bench.pool, test_bench::bounded_capacity);
+	std::cout << std::format("有界通道多生产者多消费者: {}\n", (bounded ? "PASS" : "FAIL"));
+	bool drain = test_close_drain(bench.pool);
+	std::cout << std::format("关闭与取空: {}\n", (drain ? "PASS" : "FAIL"));
+	bool sel_unbounded = test_select(bench.pool, channel<u64>::unbounded);
+	std::cout << std::format("select（无界）: {}\n", (sel_unbounded ? "PASS" : "FAIL"));
+	bool sel_bounded = test_select(bench.pool, test_bench::bounded_capacity);
+	std::cout << std::format("select（有界）: {}\n", (sel_bounded ? "PASS" : "FAIL"));
+
+	bench.pool.stop();
+
+	bool passed = unbounded && bounded && drain && sel_unbounded && sel_bounded;
+	std::cout << std::format("校验: {}\n", (passed ? "PASS" : "FAIL"));
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include "chenc/thread/lock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace chenc::lock;
+
+struct test_bench {
+	static constexpr int threads = 4;
+	static constexpr int iterations = 50'000;
+	static constexpr int exit_rounds = 300;		// 短命线程的轮数
+	static constexpr int exit_threads = 4;		// 每轮的短命线程数
+	static constexpr int seqlock_writes = 100'000;
+};
+
+// 临界区互斥检查：进入时 inside 必须为 false，计数与影子计数必须一致
+struct guarded_counter {
+	std::atomic<bool> inside{false};
+	std::atomic<uint64_t> overlaps{0};
+	uint64_t value = 0;
+	uint64_t shadow = 0;
+
+	inline void enter() {
+		if (inside.exchange(true, std::memory_order_relaxed)) {
+			overlaps.fetch_add(1, std::memory_order_relaxed);
+		}
+		value++;
+		shadow = value;
+		inside.store(false, std::memory_order_relaxed);
+	}
+
+	inline bool check(uint64_t expected) const {
+		return overlaps.load() == 0 && value == expected && shadow == expected;
+	}
+};
+
+// 多线程竞争同一把锁
+template <typename Lock>
+bool counter_stress(Lock &lock) {
+	guarded_counter c;
+	std::vector<std::thread> ts;
+	for (int t = 0; t < test_bench::threads; ++t) {
+		ts.emplace_back([&] {
+			for (int i = 0; i < test_bench::iterations; ++i) {
+				std::scoped_lock guard(lock);
+				c.enter();
+			}
+		});
+	}
+	for (auto &t : ts) {
+		t.join();
+	}
+	return c.check(uint64_t(test_bench::threads) * test_bench::iterations);
+}
+
+/**
+ * queue_mutex 交接后立即退出：持有者睡眠让等待者挂起，解锁时交接给挂起的节点；
+ * 被授予者拿到锁、解锁后马上退出线程，交接方的唤醒不能落在已释放的节点上（配合 ASan 运行）
+ */
+template <typename Lock>
+bool handoff_and_exit(Lock &lock) {
+	guarded_counter c;
+	for (int r = 0; r < test_bench::exit_rounds; ++r) {
+		std::atomic<int> ready{0};
+		lock.lock();
+		std::vector<std::thread> ts;
+		for (int t = 0; t < test_bench::exit_threads; ++t) {
+			ts.emplace_back([&] {
+				ready.fetch_add(1, std::memory_order_relaxed);
+				lock.lock();
+				c.enter();
+				lock.unlock();
+			});
+		}
+		while (ready.load(std::memory_order_relaxed) < test_bench::exit_threads) {
+			std::this_thread::yield();
+		}
+		// 等待者越过自旋预算后挂起
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		c.enter();
+		lock.unlock();
+		for (auto &t : ts) {
+			t.join();
+		}
+	}
+	return c.check(uint64_t(test_bench::exit_rounds) * (test_bench::exit_threads + 1));
+}
+
+// 递归锁：每次进入嵌套三层，只有持有者 owned() 为真
+template <typename Lock>
+bool recursive_stress(Lock &lock) {
+	guarded_counter c;
+	std::atomic<uint64_t> bad{0};
+	std::vector<std::thread> ts;
+	for (int t = 0; t < test_bench::threads; ++t) {
+		ts.emplace_back([&] {
+			for (int i = 0; i < test_bench::iterations / 4; ++i) {
+				lock.lock();
+				if (!lock.try_lock()) {
+					bad.fetch_add(1, std::memory_order_relaxed);
+				}
+				lock.lock();
+				c.enter();
+				lock.unlock();
+				lock.unlock();
+				if (!lock.owned()) {
+					bad.fetch_add(1, std::memory_order_relaxed);
+				}
+				lock.unlock();
+				if (lock.owned()) {
+					bad.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+	}
+	for (auto &t : ts) {
+		t.join();
+	}
+	return bad.load() == 0 && c.check(uint64_t(test_bench::threads) * (test_bench::iterations / 4));
+}
+
+// 限时加锁：被其他线程持有时超时返回 false，释放后可以拿到
+template <typename Lock>
+bool timed_lock(Lock &lock) {
+	lock.lock();
+	bool timed_out = false;
+	std::thread t([&] {
+		auto start = std::chrono::steady_clock::now();
+		bool got = lock.try_lock_for(std::chrono::milliseconds(20));
+		timed_out = !got && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20);
+		if (got) {
+			lock.unlock();
+		}
+	});
+	t.join();
+	lock.unlock();
+	bool later = false;
+	std::thread t2([&] {
+		later = lock.try_lock_for(std::chrono::milliseconds(20));
+		if (later) {
+			lock.unlock();
+		}
+	});
+	t2.join();
+	return timed_out && later;
+}
+
+// 顺序锁：写者保持 b == 2a、c == a + 1，读者读到的快照必须满足不变式
+struct triple {
+	uint64_t a = 0;
+	uint64_t b = 0;
+	uint64_t c = 1;
+};
+
+template <typename Lock>
+bool seqlock_consistency(Lock &lock) {
+	std::atomic<bool> stop{false};
+	std::atomic<uint64_t> torn{0};
+	std::atomic<uint64_t> reads{0};
+	std::vector<std::thread> readers;
+	for (int t = 0; t < test_bench::threads - 1; ++t) {
+		readers.emplace_back([&] {
+			uint64_t last = 0;
+			while (!stop.load(std::memory_order_relaxed)) {
+				triple v = lock.load();
+				if (v.b != 2 * v.a || v.c != v.a + 1 || v.a < last) {
+					torn.fetch_add(1, std::memory_order_relaxed);
+				}
+				last = v.a;
+				reads.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+	}
+	for (int i = 1; i <= test_bench::seqlock_writes; ++i) {
+		if (i % 2 == 0) {
+			lock.store(triple{uint64_t(i), uint64_t(2 * i), uint64_t(i + 1)});
+		} else {
+			lock.update([](triple &v) {
+				v.a++;
+				v.b = 2 * v.a;
+				v.c = v.a + 1;
+			});
+		}
+	}
+	stop.store(true, std::memory_order_relaxed);
+	for (auto &t : readers) {
+		t.join();
+	}
+	triple final = lock.load();
+	return torn.load() == 0 && final.a == uint64_t(test_bench::seqlock_writes) &&
+		   lock.version() == 2 * uint64_t(test_bench::seqlock_writes);
+}
+
+void report(std::string_view name, bool ok) {
+	std::cout << std::format("{}: {}\n", name, (ok ? "PASS" : "FAIL"));
+}
+
+int main() {
+	std::cout << "--- 锁正确性测试 ---" << std::endl;
+	std::cout << std::format("线程数: {}, 每线程加锁次数: {}, 交接退出轮数: {}\n", test_bench::threads,
+							 test_bench::iterations, test_bench::exit_rounds);
+
+	bool passed = true;
+	auto run = [&](std::string_view name, bool ok) {
+		report(name, ok);
+		passed = passed && ok;
+	};
+
+	{
+		queue_mutex<> a;
+		queue_mutex<adaptive_config> b;
+		run("queue_mutex", counter_stress(a));
+		run("queue_mutex<adaptive>", counter_stress(b));
+		run("queue_mutex 交接后退出", handoff_and_exit(a));
+		run("queue_mutex<adaptive> 交接后退出", handoff_and_exit(b));
+	}
+	{
+		futex_mutex<> a;
+		futex_mutex<adaptive_config> b;
+		run("futex_mutex", counter_stress(a));
+		run("futex_mutex<adaptive>", counter_stress(b));
+		run("futex_mutex 限时加锁", timed_lock(a));
+	}
+	{
+		recursive_mutex<> a;
+		recursive_mutex<adaptive_config> b;
+		run("recursive_mutex", recursive_stress(a));
+		run("recursive_mutex<adaptive>", recursive_stress(b));
+	}
+	{
+		cohort_mutex<> a;
+		cohort_mutex<adaptive_config, 4> b;
+		run("cohort_mutex", counter_stress(a));
+		run("cohort_mutex<adaptive, 4>", counter_stress(b));
+	}
+#if defined(__linux__)
+	{
+		pi_mutex a;
+		run("pi_mutex", counter_stress(a));
+	}
+#endif
+	{
+		seqlock<triple> a;
+		seqlock<triple, adaptive_config> b;
+		run("seqlock", seqlock_consistency(a));
+		run("seqlock<adaptive>", seqlock_consistency(b));
+	}
+
+	std::cout << std::format("校验: {}\n", (passed ? "PASS" : "FAIL"));
+	return passed ? 0 : 1;
+}